@@ -0,0 +1,141 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SingleInstance.h"
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QLockFile>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
+
+#include "SingleInstance.moc"
+
+namespace NoteVault
+{
+
+// Launches are typically from a file manager, so don't wait long on an instance that's stuck.
+static const int cConnectTimeoutMs = 500;
+static const int cWriteTimeoutMs = 1000;
+static const int cLockTimeoutMs = 2000;
+
+SingleInstance::SingleInstance(QObject* parent)
+	: QObject(parent), m_server(nullptr)
+{
+}
+
+SingleInstance::~SingleInstance()
+{
+}
+
+bool SingleInstance::forward(const QStringList& filePaths)
+{
+	QLocalSocket socket;
+	socket.connectToServer(getServerName());
+	if (!socket.waitForConnected(cConnectTimeoutMs))
+		return false;
+
+	// The running instance may have a different working directory.
+	QStringList absolutePaths;
+	for (const QString& filePath : filePaths)
+		absolutePaths.append(QFileInfo(filePath).absoluteFilePath());
+
+	QDataStream stream(&socket);
+	stream << absolutePaths;
+	if (!socket.waitForBytesWritten(cWriteTimeoutMs))
+		return false;
+
+	socket.disconnectFromServer();
+	return true;
+}
+
+bool SingleInstance::listen()
+{
+	if (m_server)
+		return true;
+
+	m_server = new QLocalServer(this);
+	m_server->setSocketOptions(QLocalServer::UserAccessOption);
+	QObject::connect(m_server, SIGNAL(newConnection()), this, SLOT(onNewConnection()));
+
+	// Launches that start at the same time take turns, so one can't remove the socket another
+	// has just started listening on.
+	QString serverName = getServerName();
+	QLockFile lockFile(QDir::temp().filePath(serverName + QStringLiteral(".lock")));
+	if (lockFile.tryLock(cLockTimeoutMs))
+	{
+		if (m_server->listen(serverName))
+			return true;
+
+		// A previous instance that crashed may have left its socket behind. Only remove it if
+		// nothing answers, since another launch may have started listening since forward().
+		QLocalSocket socket;
+		socket.connectToServer(serverName);
+		if (!socket.waitForConnected(cConnectTimeoutMs))
+		{
+			QLocalServer::removeServer(serverName);
+			if (m_server->listen(serverName))
+				return true;
+		}
+	}
+
+	delete m_server;
+	m_server = nullptr;
+	return false;
+}
+
+void SingleInstance::onNewConnection()
+{
+	while (QLocalSocket* socket = m_server->nextPendingConnection())
+	{
+		QObject::connect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+		QObject::connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+		if (socket->bytesAvailable() > 0)
+			readFiles(*socket);
+	}
+}
+
+void SingleInstance::onReadyRead()
+{
+	if (QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender()))
+		readFiles(*socket);
+}
+
+void SingleInstance::readFiles(QLocalSocket& socket)
+{
+	// The message may arrive over multiple reads.
+	QDataStream stream(&socket);
+	stream.startTransaction();
+	QStringList filePaths;
+	stream >> filePaths;
+	if (!stream.commitTransaction())
+		return;
+
+	QObject::disconnect(&socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+	socket.disconnectFromServer();
+	Q_EMIT filesReceived(filePaths);
+}
+
+QString SingleInstance::getServerName()
+{
+	// Include the home directory so each user gets their own instance.
+	QByteArray userHash = QCryptographicHash::hash(QDir::homePath().toUtf8(),
+		QCryptographicHash::Sha256).toHex().left(16);
+	return QStringLiteral("notevault-") + QString::fromLatin1(userHash);
+}
+
+} // namespace NoteVault
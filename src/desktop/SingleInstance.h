@@ -0,0 +1,60 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+
+class QLocalServer;
+class QLocalSocket;
+
+namespace NoteVault
+{
+
+// Lets later launches hand their files to the instance that's already running over a local
+// socket, skipping the cost of starting up another process. The socket is only accessible to
+// the current user.
+class SingleInstance : public QObject
+{
+	Q_OBJECT
+public:
+	explicit SingleInstance(QObject* parent = nullptr);
+	~SingleInstance();
+
+	// Sends the files to open to the running instance. Returns false if there isn't one.
+	bool forward(const QStringList& filePaths);
+
+	// Starts accepting files from later launches. Returns false if another instance is already
+	// listening, in which case the files may be forwarded to it.
+	bool listen();
+
+Q_SIGNALS:
+	// filePaths are absolute, and empty if the launch didn't have any files to open.
+	void filesReceived(const QStringList& filePaths);
+
+private Q_SLOTS:
+	void onNewConnection();
+	void onReadyRead();
+
+private:
+	static QString getServerName();
+
+	void readFiles(QLocalSocket& socket);
+
+	QLocalServer* m_server;
+};
+
+} // namespace NoteVault
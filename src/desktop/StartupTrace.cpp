@@ -0,0 +1,48 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "StartupTrace.h"
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QLoggingCategory>
+
+namespace NoteVault
+{
+
+Q_LOGGING_CATEGORY(startupLog, "notevault.startup", QtWarningMsg)
+
+static QElapsedTimer timer;
+
+void StartupTrace::start()
+{
+	timer.start();
+}
+
+void StartupTrace::mark(const char* stage)
+{
+	// Stages after startup finished, such as opening files later on, aren't logged.
+	if (!timer.isValid())
+		return;
+
+	qCInfo(startupLog, "%s: %lld ms", stage, static_cast<long long>(timer.elapsed()));
+}
+
+void StartupTrace::finish()
+{
+	mark("startup finished");
+	timer.invalidate();
+}
+
+} // namespace NoteVault
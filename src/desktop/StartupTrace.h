@@ -0,0 +1,31 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+namespace NoteVault
+{
+
+// Logs the time taken to reach each stage of startup. Enable the output by setting
+// QT_LOGGING_RULES="notevault.startup.info=true".
+class StartupTrace
+{
+public:
+	static void start();
+	static void mark(const char* stage);
+	static void finish();
+};
+
+} // namespace NoteVault
@@ -15,6 +15,7 @@
  */
 
 #include "Crypto.h"
+#include <openssl/crypto.h>
 #include <openssl/evp.h>
 #include <openssl/rand.h>
 #include <openssl/engine.h>
@@ -50,4 +51,11 @@ std::vector<uint8_t> Crypto::random(unsigned int numBytes)
 	return randBytes;
 }
 
+void Crypto::cleanse(std::vector<uint8_t>& data)
+{
+	if (!data.empty())
+		OPENSSL_cleanse(data.data(), data.size());
+	data.clear();
+}
+
 } // namespace NoteVault
@@ -1,6 +1,6 @@
 #pragma once
 /*
- * Copyright 2015 Aaron Barany
+ * Copyright 2015-2026 Aaron Barany
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -39,6 +39,10 @@ public:
 	static std::vector<uint8_t> generateKey(const std::string& password,
 		const std::vector<uint8_t>& salt, unsigned int numIterations);
 	static std::vector<uint8_t> random(unsigned int numBytes);
+
+	//Overwrites sensitive data, such as keys, so it doesn't linger in memory. The vector is
+	//cleared afterward.
+	static void cleanse(std::vector<uint8_t>& data);
 };
 
 } // namespace NoteVault
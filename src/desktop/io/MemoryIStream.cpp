@@ -0,0 +1,60 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MemoryIStream.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace NoteVault
+{
+
+MemoryIStream::MemoryIStream()
+	: m_data(nullptr), m_size(0), m_offset(0)
+{
+}
+
+MemoryIStream::MemoryIStream(const void* data, size_t size)
+	: m_data(data), m_size(size), m_offset(0)
+{
+}
+
+void MemoryIStream::open(const void* data, size_t size)
+{
+	m_data = data;
+	m_size = size;
+	m_offset = 0;
+}
+
+size_t MemoryIStream::read(void* data, size_t size)
+{
+	if (!m_data)
+		return 0;
+
+	size_t readSize = std::min(size, m_size - m_offset);
+	memcpy(data, reinterpret_cast<const uint8_t*>(m_data) + m_offset, readSize);
+	m_offset += readSize;
+	return readSize;
+}
+
+void MemoryIStream::close()
+{
+	m_data = nullptr;
+	m_size = 0;
+	m_offset = 0;
+}
+
+} // namespace NoteVault
@@ -0,0 +1,42 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "IStream.h"
+
+namespace NoteVault
+{
+
+//Reads from a buffer in memory. The buffer isn't copied, so it must outlive the stream.
+class MemoryIStream : public IStream
+{
+public:
+	MemoryIStream();
+	MemoryIStream(const void* data, size_t size);
+
+	void open(const void* data, size_t size);
+
+	//Number of bytes read so far.
+	size_t getOffset() const	{return m_offset;}
+	size_t read(void* data, size_t size) override;
+	void close() override;
+private:
+	const void* m_data;
+	size_t m_size;
+	size_t m_offset;
+};
+
+} // namespace NoteVault
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MemoryOStream.h"
+
+namespace NoteVault
+{
+
+MemoryOStream::MemoryOStream()
+{
+}
+
+std::vector<uint8_t> MemoryOStream::release()
+{
+	std::vector<uint8_t> data;
+	data.swap(m_data);
+	return data;
+}
+
+size_t MemoryOStream::write(const void* data, size_t size)
+{
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+	m_data.insert(m_data.end(), bytes, bytes + size);
+	return size;
+}
+
+void MemoryOStream::close()
+{
+}
+
+} // namespace NoteVault
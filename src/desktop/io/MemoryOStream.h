@@ -0,0 +1,42 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OStream.h"
+#include <vector>
+#include <cstdint>
+
+namespace NoteVault
+{
+
+//Writes to a growing buffer in memory.
+class MemoryOStream : public OStream
+{
+public:
+	MemoryOStream();
+
+	const std::vector<uint8_t>& getData() const	{return m_data;}
+
+	//Moves the written data out of the stream, leaving it empty.
+	std::vector<uint8_t> release();
+
+	size_t write(const void* data, size_t size) override;
+	void close() override;
+private:
+	std::vector<uint8_t> m_data;
+};
+
+} // namespace NoteVault
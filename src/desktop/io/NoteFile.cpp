@@ -19,6 +19,7 @@
 #include "CryptoIStream.h"
 #include "CryptoOStream.h"
 #include "notes/NoteSet.h"
+#include "notes/NoteSnapshot.h"
 #include <cstring>
 
 #if defined(__BIG_ENDIAN__)
@@ -41,6 +42,10 @@ namespace NoteVault
 
 static const char cMagicString[] = "NoteVault";
 
+//Version that added the folder and flags for each note.
+static const uint32_t cFolderFileVersion = 2;
+static const uint32_t cFolderFlag = 0x1;
+
 #if DO_SWAP
 static uint64_t swap(uint64_t val)
 {
@@ -95,6 +100,49 @@ static bool read(std::string& val, IStream& stream)
 	return stream.read(&val[0], val.size()) == val.size();
 }
 
+//Strings are read directly into their final storage: either the arena or a string that's adopted
+//by the note.
+static bool read(NoteString& val, IStream& stream, NoteArena* arena)
+{
+	if (!arena)
+	{
+		std::string str;
+		if (!read(str, stream))
+			return false;
+
+		val = std::move(str);
+		return true;
+	}
+
+	uint32_t length;
+	if (!read(length, stream))
+		return false;
+
+	char* data;
+	val = arena->allocate(length, data);
+	return stream.read(data, length) == length;
+}
+
+static bool read(NoteBody& val, IStream& stream, NoteArena* arena)
+{
+	if (!arena)
+	{
+		std::string str;
+		if (!read(str, stream))
+			return false;
+
+		val = std::move(str);
+		return true;
+	}
+
+	NoteString string;
+	if (!read(string, stream, arena))
+		return false;
+
+	val = NoteBody(string);
+	return true;
+}
+
 static bool write(uint64_t val, OStream& stream)
 {
 #if DO_SWAP
@@ -111,12 +159,34 @@ static bool write(uint32_t val, OStream& stream)
 	return stream.write(&val, sizeof(val)) == sizeof(val);
 }
 
-static bool write(const std::string& val, OStream& stream)
+static bool write(const NoteString& val, OStream& stream)
 {
 	if (!write(static_cast<uint32_t>(val.size()), stream))
 		return false;
 
-	return stream.write(&val[0], val.size()) == val.size();
+	return stream.write(val.data(), val.size()) == val.size();
+}
+
+static bool write(const NoteBody& val, OStream& stream)
+{
+	if (!write(static_cast<uint32_t>(val.size()), stream))
+		return false;
+
+	for (size_t i = 0; i < val.getPieceCount(); ++i)
+	{
+		const NoteBody::Piece& piece = val.getPiece(i);
+		if (stream.write(piece.data, piece.size) != piece.size)
+			return false;
+	}
+	return true;
+}
+
+unsigned int NoteFile::Header::getKeyIterations() const
+{
+	//Older file versions used a different number of iterations.
+	if (version == 0)
+		return Crypto::cVer0KeyIterations;
+	return Crypto::cDefaultKeyIterations;
 }
 
 NoteFile::Result NoteFile::loadNotes(NoteSet& notes, IStream& stream, const std::string& password,
@@ -124,6 +194,21 @@ NoteFile::Result NoteFile::loadNotes(NoteSet& notes, IStream& stream, const std:
 {
 	notes.clear();
 
+	Header header;
+	Result result = readHeader(header, stream);
+	if (result != Result::Success)
+		return result;
+
+	result = loadNotes(notes, stream, header, password, key);
+	if (result != Result::Success)
+		return result;
+
+	salt = std::move(header.salt);
+	return Result::Success;
+}
+
+NoteFile::Result NoteFile::readHeader(Header& header, IStream& stream)
+{
 	//Read the header: magic string, version, salt, and initialization vector.
 	char magicStringCheck[sizeof(cMagicString)];
 	if (stream.read(magicStringCheck, sizeof(magicStringCheck)) != sizeof(magicStringCheck) ||
@@ -132,42 +217,62 @@ NoteFile::Result NoteFile::loadNotes(NoteSet& notes, IStream& stream, const std:
 		return Result::InvalidFile;
 	}
 
-	uint32_t version;
-	if (!read(version, stream))
+	if (!read(header.version, stream))
 		return Result::IoError;
-	if (version > cFileVersion)
+	if (header.version > cFileVersion)
 		return Result::InvalidVersion;
 
 	uint32_t saltLen;
 	if (!read(saltLen, stream))
 		return Result::IoError;
-	salt.resize(saltLen);
-	if (stream.read(salt.data(), saltLen) != saltLen)
+	header.salt.resize(saltLen);
+	if (stream.read(header.salt.data(), saltLen) != saltLen)
 		return Result::IoError;
 
-	unsigned int numIterations = Crypto::cDefaultKeyIterations;
-	//If an older file version, set the number of iterations based on that version.
-	if (version == 0)
-		numIterations = Crypto::cVer0KeyIterations;
-
-	key = Crypto::generateKey(password, salt, numIterations);
-	if (key.empty())
-		return Result::EncryptionError;
-
 	uint32_t ivLen;
 	if (!read(ivLen, stream))
 		return Result::IoError;
-	std::vector<uint8_t> iv;
-	iv.resize(ivLen);
-	if (stream.read(iv.data(), ivLen) != ivLen)
+	header.iv.resize(ivLen);
+	if (stream.read(header.iv.data(), ivLen) != ivLen)
 		return Result::IoError;
 
+	return Result::Success;
+}
+
+NoteFile::Result NoteFile::loadNotes(NoteSet& notes, IStream& stream, const Header& header,
+	const std::string& password, std::vector<uint8_t>& key, const ProgressFunction& progress)
+{
+	unsigned int numIterations = header.getKeyIterations();
+	key = Crypto::generateKey(password, header.salt, numIterations);
+	if (key.empty())
+		return Result::EncryptionError;
+
+	Result result = loadNotes(notes, stream, header, key, progress);
+	if (result != Result::Success)
+		return result;
+
+	//If reading from an old file, re-calculate the key with the updated number of iterations.
+	if (numIterations != Crypto::cDefaultKeyIterations)
+	{
+		key = Crypto::generateKey(password, header.salt, Crypto::cDefaultKeyIterations);
+		if (key.empty())
+			return Result::EncryptionError;
+	}
+	return Result::Success;
+}
+
+NoteFile::Result NoteFile::loadNotes(NoteSet& notes, IStream& stream, const Header& header,
+	const std::vector<uint8_t>& key, const ProgressFunction& progress)
+{
+	notes.clear();
+
 	//Main file. (encrypted)
 	CryptoIStream cryptoStream;
-	if (!cryptoStream.open(stream, key, iv))
+	if (!cryptoStream.open(stream, key, header.iv))
 		return Result::EncryptionError;
 
 	//Read the magic string again to verify the correct key
+	char magicStringCheck[sizeof(cMagicString)];
 	memset(magicStringCheck, 0, sizeof(magicStringCheck));
 	if (cryptoStream.read(magicStringCheck, sizeof(magicStringCheck)) != sizeof(magicStringCheck))
 		return Result::IoError;
@@ -178,43 +283,68 @@ NoteFile::Result NoteFile::loadNotes(NoteSet& notes, IStream& stream, const std:
 	uint32_t numNotes;
 	if (!read(numNotes, cryptoStream))
 		return Result::IoError;
+	if (progress && !progress(notes, numNotes))
+		return Result::Canceled;
 
-	std::string title, message;
+	NoteArena* arena = notes.getArena();
 	for (uint32_t i = 0; i < numNotes; ++i)
 	{
 		uint64_t id;
 		if (!read(id, cryptoStream))
 			return Result::IoError;
 
-		if (!read(title, cryptoStream) || !read(message, cryptoStream))
+		uint64_t parentId = Note::cNoParent;
+		uint32_t flags = 0;
+		if (header.version >= cFolderFileVersion &&
+			(!read(parentId, cryptoStream) || !read(flags, cryptoStream)))
+		{
+			return Result::IoError;
+		}
+
+		//Read into fresh strings so their storage can be moved into the note without a copy.
+		NoteString title;
+		NoteBody message;
+		if (!read(title, cryptoStream, arena) || !read(message, cryptoStream, arena))
 			return Result::IoError;
 
-		Note note(id);
-		note.setTitle(title);
-		note.setMessage(message);
-		NoteSet::iterator insertIter = notes.insert(notes.end(), note);
+		Note note(id, std::move(title), std::move(message));
+		note.setParentId(parentId);
+		note.setFolder((flags & cFolderFlag) != 0);
+		NoteSet::iterator insertIter = notes.insert(notes.end(), std::move(note));
 		if (insertIter == notes.end())
 			return Result::IoError;
+		if (progress && !progress(notes, numNotes))
+		{
+			notes.clear();
+			return Result::Canceled;
+		}
 	}
 
-	//If reading from an old file, re-calculate the key with the updated number of iterations.
-	if (numIterations != Crypto::cDefaultKeyIterations)
-	{
-		key = Crypto::generateKey(password, salt, Crypto::cDefaultKeyIterations);
-		if (key.empty())
-			return Result::EncryptionError;
-	}
 	return Result::Success;
 }
 
-NoteFile::Result NoteFile::saveNotes(const NoteSet& notes, OStream& stream,
+template <typename Notes>
+static NoteFile::Result saveNoteList(const Notes& notes, OStream& stream,
 	const std::vector<uint8_t>& salt, const std::vector<uint8_t>& key)
 {
+	using Result = NoteFile::Result;
+
 	//Write the header: magic string, version, salt, and initialization vector.
 	if (stream.write(cMagicString, sizeof(cMagicString)) != sizeof(cMagicString))
 		return Result::IoError;
 
-	if (!write(cFileVersion, stream))
+	//Only use the newer version when needed so older releases can still read the file.
+	uint32_t version = 1;
+	for (const Note& note : notes)
+	{
+		if (note.isFolder() || note.getParentId() != Note::cNoParent)
+		{
+			version = cFolderFileVersion;
+			break;
+		}
+	}
+
+	if (!write(version, stream))
 		return Result::IoError;
 
 	if (!write(static_cast<uint32_t>(salt.size()), stream))
@@ -248,6 +378,13 @@ NoteFile::Result NoteFile::saveNotes(const NoteSet& notes, OStream& stream,
 		if (!write(note.getId(), cryptoStream))
 			return Result::IoError;
 
+		if (version >= cFolderFileVersion &&
+			(!write(note.getParentId(), cryptoStream) ||
+				!write(note.isFolder() ? cFolderFlag : 0U, cryptoStream)))
+		{
+			return Result::IoError;
+		}
+
 		if (!write(note.getTitle(), cryptoStream) || !write(note.getMessage(), cryptoStream))
 			return Result::IoError;
 	}
@@ -255,4 +392,16 @@ NoteFile::Result NoteFile::saveNotes(const NoteSet& notes, OStream& stream,
 	return Result::Success;
 }
 
+NoteFile::Result NoteFile::saveNotes(const NoteSet& notes, OStream& stream,
+	const std::vector<uint8_t>& salt, const std::vector<uint8_t>& key)
+{
+	return saveNoteList(notes, stream, salt, key);
+}
+
+NoteFile::Result NoteFile::saveNotes(const NoteSnapshot& notes, OStream& stream,
+	const std::vector<uint8_t>& salt, const std::vector<uint8_t>& key)
+{
+	return saveNoteList(notes, stream, salt, key);
+}
+
 } // namespace NoteVault
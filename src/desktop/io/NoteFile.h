@@ -1,6 +1,6 @@
 #pragma once
 /*
- * Copyright 2015 Aaron Barany
+ * Copyright 2015-2026 Aaron Barany
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -15,6 +15,7 @@
  * limitations under the License.
  */
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <cstdint>
@@ -25,11 +26,14 @@ namespace NoteVault
 class IStream;
 class OStream;
 class NoteSet;
+class NoteSnapshot;
 
 class NoteFile
 {
 public:
-	static const uint32_t cFileVersion = 1;
+	//Latest version that can be read. Version 2 adds folders, and files that don't use them are
+	//still written as version 1 so older releases can read them.
+	static const uint32_t cFileVersion = 2;
 
 	enum class Result
 	{
@@ -37,13 +41,40 @@ public:
 		InvalidFile,
 		InvalidVersion,
 		IoError,
-		EncryptionError
+		EncryptionError,
+		Canceled
 	};
 
+	//Unencrypted header at the start of the file.
+	struct Header
+	{
+		uint32_t version;
+		std::vector<uint8_t> salt;
+		std::vector<uint8_t> iv;
+
+		unsigned int getKeyIterations() const;
+	};
+
+	//Called once the number of notes is known and again after each note is read, so the notes
+	//loaded so far can be used before the whole file is read. Returning false stops loading,
+	//clearing the notes read so far and returning Canceled.
+	using ProgressFunction = std::function<bool(const NoteSet& notes, uint32_t totalNotes)>;
+
 	static Result loadNotes(NoteSet& notes, IStream& stream, const std::string& password,
 		std::vector<uint8_t>& salt, std::vector<uint8_t>& key);
+
+	//Loading can be split up to skip deriving the key when it's already known, such as when
+	//reloading a file. The stream must be positioned right after the header.
+	static Result readHeader(Header& header, IStream& stream);
+	static Result loadNotes(NoteSet& notes, IStream& stream, const Header& header,
+		const std::string& password, std::vector<uint8_t>& key,
+		const ProgressFunction& progress = ProgressFunction());
+	static Result loadNotes(NoteSet& notes, IStream& stream, const Header& header,
+		const std::vector<uint8_t>& key, const ProgressFunction& progress = ProgressFunction());
 	static Result saveNotes(const NoteSet& notes, OStream& stream,
 		const std::vector<uint8_t>& salt, const std::vector<uint8_t>& key);
+	static Result saveNotes(const NoteSnapshot& notes, OStream& stream,
+		const std::vector<uint8_t>& salt, const std::vector<uint8_t>& key);
 };
 
 } // namespace NoteVault
@@ -1,5 +1,5 @@
 /*
- * Copyright 2015 Aaron Barany
+ * Copyright 2015-2026 Aaron Barany
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -14,8 +14,12 @@
  * limitations under the License.
  */
 
+#include "SingleInstance.h"
+#include "StartupTrace.h"
 #include "io/Crypto.h"
 #include "ui/MainWindow.h"
+#include "ui/WindowManager.h"
+#include <QtCore/QCoreApplication>
 #include <QtWidgets/QApplication>
 
 #ifdef _WIN32
@@ -24,12 +28,50 @@
 
 int main(int argc, char** argv)
 {
-	NoteVault::Crypto::initialize();
+	NoteVault::StartupTrace::start();
+
+	// Hand the files off to an instance that's already running before paying for the rest of
+	// startup. This only needs a core application, which is much cheaper to create than the GUI
+	// application and its platform plugin.
+	QStringList filePaths;
+	bool newInstance = false;
+	NoteVault::SingleInstance singleInstance;
+	{
+		QCoreApplication coreApp(argc, argv);
+		QStringList arguments = coreApp.arguments();
+		for (int i = 1; i < arguments.size(); ++i)
+		{
+			if (arguments[i] == "--new-instance")
+				newInstance = true;
+			else
+				filePaths.append(arguments[i]);
+		}
+
+		if (!newInstance && singleInstance.forward(filePaths))
+			return 0;
+	}
+	NoteVault::StartupTrace::mark("single instance checked");
+
 	QApplication app(argc, argv);
-	NoteVault::MainWindow mainWindow;
+	NoteVault::StartupTrace::mark("application created");
+
+	// Another launch may have started listening first, in which case forward to it instead.
+	if (!newInstance && !singleInstance.listen() && singleInstance.forward(filePaths))
+		return 0;
+
+	NoteVault::Crypto::initialize();
+	NoteVault::StartupTrace::mark("crypto initialized");
+
+	NoteVault::WindowManager windowManager;
+	QObject::connect(&singleInstance, SIGNAL(filesReceived(const QStringList&)),
+		&windowManager, SLOT(openFiles(const QStringList&)));
+	NoteVault::MainWindow* mainWindow = windowManager.createWindow();
+	NoteVault::StartupTrace::mark("main window created");
 
-	mainWindow.show();
-	if (argc > 1)
-		mainWindow.open(argv[1]);
+	mainWindow->show();
+	NoteVault::StartupTrace::mark("main window shown");
+	if (!filePaths.isEmpty())
+		windowManager.openFiles(filePaths);
+	NoteVault::StartupTrace::finish();
 	return app.exec();
 }
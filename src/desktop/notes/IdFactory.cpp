@@ -1,5 +1,5 @@
 /*
- * Copyright 2015 Aaron Barany
+ * Copyright 2015-2026 Aaron Barany
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -20,34 +20,126 @@
 namespace NoteVault
 {
 
-IdFactory::IdFactory()
-	: m_maxId(0)
+const unsigned int IdFactory::cWordBits;
+const uint64_t IdFactory::cMinDenseIds;
+
+IdFactory::IdFactory(RecyclePolicy policy)
+	: m_policy(policy), m_maxId(0), m_count(0), m_firstFreeWord(0)
 {
 }
 
 bool IdFactory::addId(uint64_t id)
 {
-	if (!m_ids.insert(id).second)
+	if (!isDense(id) && canGrowDense(id))
+		growDense(id);
+
+	if (isDense(id))
+	{
+		uint64_t& word = m_bits[id/cWordBits];
+		uint64_t bit = 1ULL << (id % cWordBits);
+		if (word & bit)
+			return false;
+		word |= bit;
+	}
+	else if (!m_sparseIds.insert(id).second)
 		return false;
+
+	++m_count;
 	m_maxId = std::max(m_maxId, id + 1);
 	return true;
 }
 
 uint64_t IdFactory::newId()
 {
-	uint64_t newId = m_maxId++;
-	m_ids.insert(newId);
+	uint64_t newId = m_policy == RecyclePolicy::Lowest ? findLowestFree() : m_maxId;
+	addId(newId);
 	return newId;
 }
 
 bool IdFactory::removeId(uint64_t id)
 {
-	return m_ids.erase(id) > 0;
+	if (isDense(id))
+	{
+		uint64_t& word = m_bits[id/cWordBits];
+		uint64_t bit = 1ULL << (id % cWordBits);
+		if (!(word & bit))
+			return false;
+		word &= ~bit;
+		m_firstFreeWord = std::min(m_firstFreeWord, static_cast<size_t>(id/cWordBits));
+	}
+	else if (m_sparseIds.erase(id) == 0)
+		return false;
+
+	--m_count;
+	return true;
+}
+
+bool IdFactory::contains(uint64_t id) const
+{
+	if (isDense(id))
+		return (m_bits[id/cWordBits] & (1ULL << (id % cWordBits))) != 0;
+	return m_sparseIds.count(id) > 0;
 }
 
 void IdFactory::clear()
 {
-	m_ids.clear();
+	m_bits.clear();
+	m_sparseIds.clear();
+	m_maxId = 0;
+	m_count = 0;
+	m_firstFreeWord = 0;
+}
+
+bool IdFactory::canGrowDense(uint64_t id) const
+{
+	//Keep the bitmap to at most a word per id in use, which is still far smaller than a hash set
+	//entry.
+	uint64_t maxDenseIds = std::max(cMinDenseIds, static_cast<uint64_t>(m_count + 1)*cWordBits);
+	return id < maxDenseIds;
+}
+
+void IdFactory::growDense(uint64_t id)
+{
+	size_t oldSize = m_bits.size();
+	size_t newSize = std::max(static_cast<size_t>(id/cWordBits + 1), oldSize*2);
+	newSize = std::min(newSize,
+		static_cast<size_t>(std::max(cMinDenseIds, static_cast<uint64_t>(m_count + 1)*cWordBits)/
+			cWordBits));
+	m_bits.resize(newSize, 0);
+
+	//Move any sparse ids that are now in range of the bitmap.
+	for (std::unordered_set<uint64_t>::iterator iter = m_sparseIds.begin();
+		iter != m_sparseIds.end();)
+	{
+		if (isDense(*iter))
+		{
+			m_bits[*iter/cWordBits] |= 1ULL << (*iter % cWordBits);
+			iter = m_sparseIds.erase(iter);
+		}
+		else
+			++iter;
+	}
+}
+
+uint64_t IdFactory::findLowestFree()
+{
+	for (; m_firstFreeWord < m_bits.size(); ++m_firstFreeWord)
+	{
+		uint64_t word = m_bits[m_firstFreeWord];
+		if (word == ~0ULL)
+			continue;
+
+		unsigned int bit = 0;
+		while (word & (1ULL << bit))
+			++bit;
+		return m_firstFreeWord*cWordBits + bit;
+	}
+
+	//Past the end of the bitmap, skipping any sparse ids that are in the way.
+	uint64_t id = static_cast<uint64_t>(m_bits.size())*cWordBits;
+	while (m_sparseIds.count(id) > 0)
+		++id;
+	return id;
 }
 
 } // namespace NoteVault
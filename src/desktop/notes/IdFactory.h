@@ -1,6 +1,6 @@
 #pragma once
 /*
- * Copyright 2015 Aaron Barany
+ * Copyright 2015-2026 Aaron Barany
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -16,25 +16,52 @@
  */
 
 #include <unordered_set>
+#include <vector>
+#include <cstddef>
 #include <cstdint>
 
 namespace NoteVault
 {
 
+//Tracks ids in use. Mostly contiguous ids are kept in a bitmap, using a bit per id, and ids far
+//outside of the bitmap's range fall back to a hash set.
 class IdFactory
 {
 public:
-	IdFactory();
+	enum class RecyclePolicy
+	{
+		Never,  //New ids are always larger than any id used since the last clear.
+		Lowest  //New ids reuse the lowest free id.
+	};
+
+	explicit IdFactory(RecyclePolicy policy = RecyclePolicy::Never);
+
+	RecyclePolicy getRecyclePolicy() const	{return m_policy;}
+	void setRecyclePolicy(RecyclePolicy policy)	{m_policy = policy;}
 
 	bool addId(uint64_t id);
 	uint64_t newId();
 	bool removeId(uint64_t id);
+	bool contains(uint64_t id) const;
 
+	size_t size() const	{return m_count;}
 	void clear();
 
 private:
-	std::unordered_set<uint64_t> m_ids;
+	static const unsigned int cWordBits = 64;
+	static const uint64_t cMinDenseIds = 64*1024;
+
+	bool isDense(uint64_t id) const	{return id/cWordBits < m_bits.size();}
+	bool canGrowDense(uint64_t id) const;
+	void growDense(uint64_t id);
+	uint64_t findLowestFree();
+
+	RecyclePolicy m_policy;
+	std::vector<uint64_t> m_bits;
+	std::unordered_set<uint64_t> m_sparseIds;
 	uint64_t m_maxId;
+	size_t m_count;
+	size_t m_firstFreeWord;
 };
 
 } // namespace NoteVault
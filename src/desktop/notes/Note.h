@@ -1,6 +1,6 @@
 #pragma once
 /*
- * Copyright 2015 Aaron Barany
+ * Copyright 2015-2026 Aaron Barany
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -15,7 +15,9 @@
  * limitations under the License.
  */
 
-#include <string>
+#include "NoteBody.h"
+#include "NoteString.h"
+#include <utility>
 #include <cstdint>
 
 namespace NoteVault
@@ -24,23 +26,43 @@ namespace NoteVault
 class Note
 {
 public:
+	//Parent id of notes that aren't in a folder.
+	static const uint64_t cNoParent = static_cast<uint64_t>(-1);
+
 	explicit Note(uint64_t id)
-		: m_id(id) {}
+		: m_id(id), m_parentId(cNoParent), m_folder(false) {}
+	Note(uint64_t id, NoteString title, NoteBody message)
+		: m_id(id), m_parentId(cNoParent), m_folder(false), m_title(std::move(title)),
+		m_message(std::move(message)) {}
+
+	Note(const Note& other) = default;
+	Note(Note&& other) = default;
 
 	Note& operator=(const Note& other);
+	Note& operator=(Note&& other);
 
 	uint64_t getId() const	{return m_id;}
 
-	const std::string& getTitle() const	{return m_title;}
-	void setTitle(const std::string& title)	{m_title = title;}
+	//Folders are notes that other notes can be placed in. Whether a note is a folder is set when
+	//it's created.
+	uint64_t getParentId() const	{return m_parentId;}
+	void setParentId(uint64_t parentId)	{m_parentId = parentId;}
+	bool isFolder() const	{return m_folder;}
+	void setFolder(bool folder)	{m_folder = folder;}
 
-	const std::string& getMessage() const	{return m_message;}
-	void setMessage(const std::string& message)	{m_message = message;}
+	const NoteString& getTitle() const	{return m_title;}
+	void setTitle(NoteString title)	{m_title = std::move(title);}
+
+	const NoteBody& getMessage() const	{return m_message;}
+	void setMessage(NoteBody message)	{m_message = std::move(message);}
+	void replaceMessage(size_t offset, size_t length, const char* data, size_t dataLength);
 
 private:
 	uint64_t m_id;
-	std::string m_title;
-	std::string m_message;
+	uint64_t m_parentId;
+	bool m_folder;
+	NoteString m_title;
+	NoteBody m_message;
 };
 
 inline Note& Note::operator=(const Note& other)
@@ -48,9 +70,29 @@ inline Note& Note::operator=(const Note& other)
 	if (this == &other)
 		return *this;
 
+	m_parentId = other.m_parentId;
+	m_folder = other.m_folder;
 	m_title = other.m_title;
 	m_message = other.m_message;
 	return *this;
 }
 
+inline void Note::replaceMessage(size_t offset, size_t length, const char* data,
+	size_t dataLength)
+{
+	m_message.replace(offset, length, data, dataLength);
+}
+
+inline Note& Note::operator=(Note&& other)
+{
+	if (this == &other)
+		return *this;
+
+	m_parentId = other.m_parentId;
+	m_folder = other.m_folder;
+	m_title = std::move(other.m_title);
+	m_message = std::move(other.m_message);
+	return *this;
+}
+
 } // namespace NoteVault
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NoteArena.h"
+#include <cstring>
+
+namespace NoteVault
+{
+
+NoteArena::NoteArena(size_t blockSize)
+	: m_blockSize(blockSize)
+{
+}
+
+NoteArena::NoteArena(const NoteArena& other)
+	: m_blockSize(other.m_blockSize)
+{
+	//Blocks are appended to, so never share the current block between arenas.
+}
+
+NoteArena& NoteArena::operator=(const NoteArena& other)
+{
+	if (this == &other)
+		return *this;
+
+	m_blockSize = other.m_blockSize;
+	m_curBlock.reset();
+	return *this;
+}
+
+NoteString NoteArena::allocate(size_t length, char*& data)
+{
+	size_t allocSize = length + 1;
+	std::shared_ptr<TextBlock> block;
+	//Large strings get their own block so they don't waste the rest of the current one.
+	if (allocSize > m_blockSize/4)
+		block = std::make_shared<TextBlock>(allocSize);
+	else
+	{
+		if (!m_curBlock || m_curBlock->getAvailable() < allocSize)
+			m_curBlock = std::make_shared<TextBlock>(m_blockSize);
+		block = m_curBlock;
+	}
+
+	data = block->append(allocSize);
+	data[length] = 0;
+	return NoteString(std::move(block), data, length);
+}
+
+NoteString NoteArena::copy(const char* str, size_t length)
+{
+	char* data;
+	NoteString string = allocate(length, data);
+	memcpy(data, str, length);
+	return string;
+}
+
+void NoteArena::reset()
+{
+	m_curBlock.reset();
+}
+
+} // namespace NoteVault
@@ -0,0 +1,52 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NoteString.h"
+#include "TextBlock.h"
+#include <memory>
+#include <cstddef>
+
+namespace NoteVault
+{
+
+//Allocates note strings out of large shared blocks to avoid a heap allocation per string.
+class NoteArena
+{
+public:
+	static const size_t cDefaultBlockSize = 1024*1024;
+
+	explicit NoteArena(size_t blockSize = cDefaultBlockSize);
+	NoteArena(const NoteArena& other);
+	NoteArena(NoteArena&& other) = default;
+
+	NoteArena& operator=(const NoteArena& other);
+	NoteArena& operator=(NoteArena&& other) = default;
+
+	//Allocates a null-terminated string of length bytes. The caller must fill in data before the
+	//string is shared.
+	NoteString allocate(size_t length, char*& data);
+	NoteString copy(const char* str, size_t length);
+
+	const TextBlock* getCurrentBlock() const	{return m_curBlock.get();}
+	void reset();
+
+private:
+	size_t m_blockSize;
+	std::shared_ptr<TextBlock> m_curBlock;
+};
+
+} // namespace NoteVault
@@ -0,0 +1,402 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NoteBody.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace NoteVault
+{
+
+const size_t NoteBody::cMaxPieceSize;
+const size_t NoteBody::cAppendBlockSize;
+const size_t NoteBody::cMaxPieceCount;
+const size_t NoteBody::Piece::cUnknownSize;
+
+static size_t findCharBoundary(const char* data, size_t offset)
+{
+	while (offset > 0 && (static_cast<unsigned char>(data[offset]) & 0xC0) == 0x80)
+		--offset;
+	return offset;
+}
+
+static size_t countUtf16(const char* data, size_t size)
+{
+	//Every character is a single code unit, other than 4 byte sequences which need a surrogate
+	//pair.
+	size_t count = 0;
+	for (size_t i = 0; i < size; ++i)
+	{
+		unsigned char c = static_cast<unsigned char>(data[i]);
+		if ((c & 0xC0) != 0x80)
+			count += c >= 0xF0 ? 2 : 1;
+	}
+	return count;
+}
+
+NoteBody::NoteBody()
+	: m_size(0)
+{
+}
+
+NoteBody::NoteBody(std::string str)
+	: m_size(0)
+{
+	if (str.empty())
+		return;
+
+	std::shared_ptr<const TextBlock> block = std::make_shared<TextBlock>(std::move(str));
+	addPieces(m_pieces, block, block->data(), block->getSize());
+	updateOffsets(0);
+}
+
+NoteBody::NoteBody(const char* str)
+	: NoteBody(std::string(str))
+{
+}
+
+NoteBody::NoteBody(const NoteString& string)
+	: m_size(0)
+{
+	if (string.empty())
+		return;
+
+	if (string.isArenaBacked())
+		addPieces(m_pieces, string.getSharedBlock(), string.data(), string.size());
+	else
+	{
+		std::shared_ptr<const TextBlock> block = std::make_shared<TextBlock>(string.str());
+		addPieces(m_pieces, block, block->data(), block->getSize());
+	}
+	updateOffsets(0);
+}
+
+NoteBody::NoteBody(const NoteBody& other)
+	: m_pieces(other.m_pieces), m_offsets(other.m_offsets), m_size(other.m_size)
+{
+	//Copies start their own append block so edits to either body never share writes.
+}
+
+NoteBody& NoteBody::operator=(const NoteBody& other)
+{
+	if (this == &other)
+		return *this;
+
+	m_pieces = other.m_pieces;
+	m_offsets = other.m_offsets;
+	m_size = other.m_size;
+	m_appendBlock.reset();
+	return *this;
+}
+
+char NoteBody::at(size_t index) const
+{
+	assert(index < m_size);
+	size_t piece = findPiece(index);
+	return m_pieces[piece].data[index - m_offsets[piece]];
+}
+
+std::string NoteBody::str() const
+{
+	std::string str;
+	str.reserve(m_size);
+	for (const Piece& piece : m_pieces)
+		str.append(piece.data, piece.size);
+	return str;
+}
+
+std::string NoteBody::substr(size_t offset, size_t length) const
+{
+	assert(offset <= m_size);
+	length = std::min(length, m_size - offset);
+
+	std::string str;
+	str.reserve(length);
+	for (size_t i = findPiece(offset); i < m_pieces.size() && str.size() < length; ++i)
+	{
+		const Piece& piece = m_pieces[i];
+		size_t pieceOffset = str.empty() ? offset - m_offsets[i] : 0;
+		size_t copySize = std::min(piece.size - pieceOffset, length - str.size());
+		str.append(piece.data + pieceOffset, copySize);
+	}
+	return str;
+}
+
+size_t NoteBody::utf16Size() const
+{
+	size_t size = 0;
+	for (const Piece& piece : m_pieces)
+		size += getUtf16Size(piece);
+	return size;
+}
+
+size_t NoteBody::utf16ToOffset(size_t utf16Offset) const
+{
+	for (size_t i = 0; i < m_pieces.size(); ++i)
+	{
+		const Piece& piece = m_pieces[i];
+		size_t pieceUtf16Size = getUtf16Size(piece);
+		if (utf16Offset >= pieceUtf16Size)
+		{
+			utf16Offset -= pieceUtf16Size;
+			continue;
+		}
+
+		size_t pieceOffset = 0;
+		while (utf16Offset > 0)
+		{
+			unsigned char c = static_cast<unsigned char>(piece.data[pieceOffset]);
+			utf16Offset -= std::min(utf16Offset, static_cast<size_t>(c >= 0xF0 ? 2 : 1));
+			do
+				++pieceOffset;
+			while (pieceOffset < piece.size &&
+				(static_cast<unsigned char>(piece.data[pieceOffset]) & 0xC0) == 0x80);
+		}
+		return m_offsets[i] + pieceOffset;
+	}
+
+	return m_size;
+}
+
+void NoteBody::replace(size_t offset, size_t length, const char* data, size_t dataLength)
+{
+	assert(offset <= m_size && length <= m_size - offset);
+	if (length == 0 && (dataLength == 0 || tryExtend(offset, data, dataLength)))
+		return;
+
+	size_t first = splitAt(offset);
+	size_t last = splitAt(offset + length);
+
+	std::vector<Piece> newPieces;
+	appendText(newPieces, data, dataLength);
+	m_pieces.erase(m_pieces.begin() + first, m_pieces.begin() + last);
+	m_pieces.insert(m_pieces.begin() + first, newPieces.begin(), newPieces.end());
+	m_size = m_size - length + dataLength;
+	updateOffsets(first);
+
+	//Large notes start with a piece for every cMaxPieceSize bytes, and consolidating leaves
+	//smaller pieces between the larger ones, so the limit grows with the size.
+	if (m_pieces.size() > cMaxPieceCount + 2*(m_size/cAppendBlockSize))
+		consolidate();
+}
+
+bool NoteBody::operator==(const NoteBody& other) const
+{
+	if (m_size != other.m_size)
+		return false;
+
+	size_t piece = 0, pieceOffset = 0;
+	size_t otherPiece = 0, otherPieceOffset = 0;
+	while (piece < m_pieces.size())
+	{
+		const Piece& left = m_pieces[piece];
+		const Piece& right = other.m_pieces[otherPiece];
+		size_t compareSize = std::min(left.size - pieceOffset, right.size - otherPieceOffset);
+		if (memcmp(left.data + pieceOffset, right.data + otherPieceOffset, compareSize) != 0)
+			return false;
+
+		pieceOffset += compareSize;
+		if (pieceOffset == left.size)
+		{
+			++piece;
+			pieceOffset = 0;
+		}
+
+		otherPieceOffset += compareSize;
+		if (otherPieceOffset == right.size)
+		{
+			++otherPiece;
+			otherPieceOffset = 0;
+		}
+	}
+
+	return true;
+}
+
+void NoteBody::addPieces(std::vector<Piece>& pieces, std::shared_ptr<const TextBlock> block,
+	const char* data, size_t size)
+{
+	while (size > 0)
+	{
+		size_t pieceSize = size;
+		if (pieceSize > cMaxPieceSize)
+		{
+			pieceSize = findCharBoundary(data, cMaxPieceSize);
+			if (pieceSize == 0)
+				pieceSize = cMaxPieceSize;
+		}
+
+		Piece piece = {block, data, pieceSize};
+		pieces.push_back(piece);
+		data += pieceSize;
+		size -= pieceSize;
+	}
+}
+
+void NoteBody::appendText(std::vector<Piece>& pieces, const char* data, size_t size)
+{
+	if (size == 0)
+		return;
+
+	//Large insertions get a dedicated block rather than fragmenting the append block.
+	if (size > cAppendBlockSize)
+	{
+		std::shared_ptr<TextBlock> block = std::make_shared<TextBlock>(size);
+		char* blockData = block->append(size);
+		memcpy(blockData, data, size);
+		addPieces(pieces, block, blockData, size);
+		return;
+	}
+
+	if (!m_appendBlock || m_appendBlock->getAvailable() < size)
+		m_appendBlock = std::make_shared<TextBlock>(cAppendBlockSize);
+
+	char* blockData = m_appendBlock->append(size);
+	memcpy(blockData, data, size);
+	Piece piece = {m_appendBlock, blockData, size};
+	pieces.push_back(piece);
+}
+
+size_t NoteBody::findPiece(size_t offset) const
+{
+	assert(!m_offsets.empty());
+	std::vector<size_t>::const_iterator foundIter =
+		std::upper_bound(m_offsets.begin(), m_offsets.end(), offset);
+	return foundIter - m_offsets.begin() - 1;
+}
+
+size_t NoteBody::getUtf16Size(const Piece& piece) const
+{
+	if (piece.utf16Size == Piece::cUnknownSize)
+		piece.utf16Size = countUtf16(piece.data, piece.size);
+	return piece.utf16Size;
+}
+
+size_t NoteBody::splitAt(size_t offset)
+{
+	if (offset == m_size)
+		return m_pieces.size();
+
+	size_t index = findPiece(offset);
+	size_t pieceOffset = offset - m_offsets[index];
+	if (pieceOffset == 0)
+		return index;
+
+	Piece right = m_pieces[index];
+	right.data += pieceOffset;
+	right.size -= pieceOffset;
+	m_pieces[index].size = pieceOffset;
+	if (right.utf16Size != Piece::cUnknownSize)
+	{
+		m_pieces[index].utf16Size = countUtf16(m_pieces[index].data, pieceOffset);
+		right.utf16Size -= m_pieces[index].utf16Size;
+	}
+	m_pieces.insert(m_pieces.begin() + index + 1, right);
+	m_offsets.insert(m_offsets.begin() + index + 1, offset);
+	return index + 1;
+}
+
+bool NoteBody::tryExtend(size_t offset, const char* data, size_t size)
+{
+	//Typing usually appends to the piece that was just inserted, which can grow in place when it
+	//ends at the tail of the append block.
+	if (offset == 0 || !m_appendBlock || m_appendBlock->getAvailable() < size)
+		return false;
+
+	size_t index = findPiece(offset - 1);
+	Piece& piece = m_pieces[index];
+	if (m_offsets[index] + piece.size != offset || piece.block != m_appendBlock ||
+		piece.data + piece.size != m_appendBlock->data() + m_appendBlock->getSize() ||
+		piece.size + size > cMaxPieceSize)
+	{
+		return false;
+	}
+
+	memcpy(m_appendBlock->append(size), data, size);
+	piece.size += size;
+	if (piece.utf16Size != Piece::cUnknownSize)
+		piece.utf16Size += countUtf16(data, size);
+	m_size += size;
+	updateOffsets(index + 1);
+	return true;
+}
+
+void NoteBody::updateOffsets(size_t firstPiece)
+{
+	m_offsets.resize(m_pieces.size());
+	if (m_pieces.empty())
+	{
+		m_size = 0;
+		return;
+	}
+
+	size_t offset = firstPiece == 0 ? 0 : m_offsets[firstPiece - 1] + m_pieces[firstPiece - 1].size;
+	for (size_t i = firstPiece; i < m_pieces.size(); ++i)
+	{
+		m_offsets[i] = offset;
+		offset += m_pieces[i].size;
+	}
+	m_size = offset;
+}
+
+void NoteBody::consolidate()
+{
+	//Only runs of neighboring small pieces, which are left behind by edits, are copied into a new
+	//block. Larger pieces are kept as they are so the cost doesn't depend on the size of the note.
+	std::vector<Piece> pieces;
+	pieces.reserve(m_pieces.size());
+	size_t i = 0;
+	while (i < m_pieces.size())
+	{
+		size_t runEnd = i;
+		size_t runSize = 0;
+		while (runEnd < m_pieces.size() && m_pieces[runEnd].size < cAppendBlockSize &&
+			runSize + m_pieces[runEnd].size <= cMaxPieceSize)
+		{
+			runSize += m_pieces[runEnd].size;
+			++runEnd;
+		}
+
+		if (runEnd - i < 2)
+		{
+			pieces.push_back(m_pieces[i++]);
+			continue;
+		}
+
+		std::shared_ptr<TextBlock> block = std::make_shared<TextBlock>(runSize);
+		char* blockData = block->append(runSize);
+		size_t utf16Size = 0;
+		for (size_t offset = 0; i < runEnd; ++i)
+		{
+			const Piece& piece = m_pieces[i];
+			memcpy(blockData + offset, piece.data, piece.size);
+			offset += piece.size;
+			if (utf16Size != Piece::cUnknownSize)
+				utf16Size = piece.utf16Size == Piece::cUnknownSize ? Piece::cUnknownSize :
+					utf16Size + piece.utf16Size;
+		}
+
+		Piece piece = {block, blockData, runSize};
+		piece.utf16Size = utf16Size;
+		pieces.push_back(piece);
+	}
+
+	m_pieces.swap(pieces);
+	updateOffsets(0);
+}
+
+} // namespace NoteVault
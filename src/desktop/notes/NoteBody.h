@@ -0,0 +1,103 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NoteString.h"
+#include "TextBlock.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace NoteVault
+{
+
+//Piece table for note messages. Pieces reference shared, immutable TextBlocks, so copying a body
+//only copies the piece list and edits cost proportional to the size of the change. Pieces are
+//always split on UTF-8 character boundaries.
+class NoteBody
+{
+public:
+	struct Piece
+	{
+		static const size_t cUnknownSize = static_cast<size_t>(-1);
+
+		Piece(std::shared_ptr<const TextBlock> block_, const char* data_, size_t size_)
+			: block(std::move(block_)), data(data_), size(size_), utf16Size(cUnknownSize)
+		{
+		}
+
+		std::shared_ptr<const TextBlock> block;
+		const char* data;
+		size_t size;
+
+		//Length when converted to UTF-16, computed the first time it's needed.
+		mutable size_t utf16Size;
+	};
+
+	static const size_t cMaxPieceSize = 64*1024;
+	static const size_t cAppendBlockSize = 4096;
+	static const size_t cMaxPieceCount = 1024;
+
+	NoteBody();
+	NoteBody(std::string str);
+	NoteBody(const char* str);
+	NoteBody(const NoteString& string);
+	NoteBody(const NoteBody& other);
+	NoteBody(NoteBody&& other) = default;
+
+	NoteBody& operator=(const NoteBody& other);
+	NoteBody& operator=(NoteBody&& other) = default;
+
+	size_t size() const	{return m_size;}
+	bool empty() const	{return m_size == 0;}
+
+	char at(size_t index) const;
+	std::string str() const;
+	std::string substr(size_t offset, size_t length) const;
+
+	//Conversions for editors that index text by UTF-16 code units.
+	size_t utf16Size() const;
+	size_t utf16ToOffset(size_t utf16Offset) const;
+
+	void insert(size_t offset, const char* data, size_t length)	{replace(offset, 0, data, length);}
+	void erase(size_t offset, size_t length)	{replace(offset, length, nullptr, 0);}
+	void replace(size_t offset, size_t length, const char* data, size_t dataLength);
+
+	size_t getPieceCount() const	{return m_pieces.size();}
+	const Piece& getPiece(size_t index) const	{return m_pieces[index];}
+
+	bool operator==(const NoteBody& other) const;
+	bool operator!=(const NoteBody& other) const	{return !(*this == other);}
+
+private:
+	void addPieces(std::vector<Piece>& pieces, std::shared_ptr<const TextBlock> block,
+		const char* data, size_t size);
+	void appendText(std::vector<Piece>& pieces, const char* data, size_t size);
+	size_t findPiece(size_t offset) const;
+	size_t getUtf16Size(const Piece& piece) const;
+	size_t splitAt(size_t offset);
+	bool tryExtend(size_t offset, const char* data, size_t size);
+	void updateOffsets(size_t firstPiece);
+	void consolidate();
+
+	std::vector<Piece> m_pieces;
+	std::vector<size_t> m_offsets;
+	size_t m_size;
+	std::shared_ptr<TextBlock> m_appendBlock;
+};
+
+} // namespace NoteVault
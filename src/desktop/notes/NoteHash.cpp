@@ -0,0 +1,106 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NoteHash.h"
+#include "Note.h"
+#include "NoteSet.h"
+#include "NoteSnapshot.h"
+
+namespace NoteVault
+{
+
+const uint64_t NoteHash::cOffsetBasis;
+const uint64_t NoteHash::cPrime;
+
+static uint64_t hashSize(uint64_t size, uint64_t seed)
+{
+	//Hash sizes with a fixed byte order so the result doesn't depend on the platform.
+	uint8_t bytes[sizeof(uint64_t)];
+	for (unsigned int i = 0; i < sizeof(uint64_t); ++i)
+		bytes[i] = static_cast<uint8_t>(size >> i*8);
+	return NoteHash::hash(bytes, sizeof(bytes), seed);
+}
+
+uint64_t NoteHash::hash(const void* data, size_t size, uint64_t seed)
+{
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+	uint64_t result = seed;
+	for (size_t i = 0; i < size; ++i)
+	{
+		result ^= bytes[i];
+		result *= cPrime;
+	}
+	return result;
+}
+
+uint64_t NoteHash::hash(const NoteBody& body, uint64_t seed)
+{
+	//Hash piecewise so bodies with the same text hash the same regardless of how they're split.
+	uint64_t result = hashSize(body.size(), seed);
+	for (size_t i = 0; i < body.getPieceCount(); ++i)
+	{
+		const NoteBody::Piece& piece = body.getPiece(i);
+		result = hash(piece.data, piece.size, result);
+	}
+	return result;
+}
+
+uint64_t NoteHash::hash(const Note& note, uint64_t seed)
+{
+	uint64_t result = hashSize(note.getId(), seed);
+	result = hashSize(note.getParentId(), result);
+	result = hashSize(note.isFolder(), result);
+	const NoteString& title = note.getTitle();
+	result = hashSize(title.size(), result);
+	result = hash(title.data(), title.size(), result);
+	return hash(note.getMessage(), result);
+}
+
+uint64_t NoteHash::hash(const NoteSet& notes)
+{
+	uint64_t result = hashSize(notes.size(), cOffsetBasis);
+	for (const Note& note : notes)
+		result = hashSize(hash(note), result);
+	return result;
+}
+
+template <typename Notes>
+static uint64_t hashNotes(const Notes& notes, NoteHash::NoteMap& noteHashes)
+{
+	noteHashes.clear();
+	noteHashes.reserve(notes.size());
+
+	uint64_t result = hashSize(notes.size(), NoteHash::cOffsetBasis);
+	for (const Note& note : notes)
+	{
+		uint64_t noteHash = NoteHash::hash(note);
+		noteHashes.emplace(note.getId(), noteHash);
+		result = hashSize(noteHash, result);
+	}
+	return result;
+}
+
+uint64_t NoteHash::hash(const NoteSet& notes, NoteMap& noteHashes)
+{
+	return hashNotes(notes, noteHashes);
+}
+
+uint64_t NoteHash::hash(const NoteSnapshot& notes, NoteMap& noteHashes)
+{
+	return hashNotes(notes, noteHashes);
+}
+
+} // namespace NoteVault
@@ -0,0 +1,53 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace NoteVault
+{
+
+class Note;
+class NoteBody;
+class NoteSet;
+class NoteSnapshot;
+
+//64-bit FNV-1a hashes of note contents. These are only meant to detect changes cheaply, not to
+//authenticate contents.
+class NoteHash
+{
+public:
+	//Hashes of individual notes by id.
+	using NoteMap = std::unordered_map<uint64_t, uint64_t>;
+
+	static const uint64_t cOffsetBasis = 14695981039346656037ULL;
+	static const uint64_t cPrime = 1099511628211ULL;
+
+	static uint64_t hash(const void* data, size_t size, uint64_t seed = cOffsetBasis);
+	static uint64_t hash(const NoteBody& body, uint64_t seed = cOffsetBasis);
+
+	//Covers the id, folder, title, and message.
+	static uint64_t hash(const Note& note, uint64_t seed = cOffsetBasis);
+
+	//Covers every note in display order. The hashes of the individual notes may also be returned.
+	static uint64_t hash(const NoteSet& notes);
+	static uint64_t hash(const NoteSet& notes, NoteMap& noteHashes);
+	static uint64_t hash(const NoteSnapshot& notes, NoteMap& noteHashes);
+};
+
+} // namespace NoteVault
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NoteMerge.h"
+#include "NoteSet.h"
+#include <unordered_map>
+
+namespace NoteVault
+{
+
+void NoteMerge::diff(Result& result, const NoteSet& local,
+	const std::unordered_set<uint64_t>& modifiedIds, const NoteHash::NoteMap& baseHashes,
+	const NoteHash::NoteMap& remoteHashes)
+{
+	result = Result();
+
+	for (const NoteHash::NoteMap::value_type& remoteHash : remoteHashes)
+	{
+		uint64_t id = remoteHash.first;
+		NoteHash::NoteMap::const_iterator baseIter = baseHashes.find(id);
+		bool remoteChanged = baseIter == baseHashes.end() || baseIter->second != remoteHash.second;
+		if (modifiedIds.find(id) == modifiedIds.end())
+		{
+			if (remoteChanged)
+				result.updated.push_back(id);
+			continue;
+		}
+
+		//Only hash the notes changed locally, which both sides may have changed the same way.
+		const Note* localNote = local.find_note(id);
+		if (localNote && NoteHash::hash(*localNote) == remoteHash.second)
+			continue;
+
+		if (!remoteChanged)
+			result.pending.push_back(id);
+		else if (baseIter != baseHashes.end())
+			result.conflicts.push_back(id);
+		else
+		{
+			//Added on both sides, which only share the id since it was the next one free.
+			if (localNote)
+				result.duplicates.emplace_back(id, id);
+			result.updated.push_back(id);
+		}
+	}
+
+	for (const NoteHash::NoteMap::value_type& baseHash : baseHashes)
+	{
+		uint64_t id = baseHash.first;
+		if (remoteHashes.find(id) != remoteHashes.end() || !local.find_note(id))
+			continue;
+
+		if (modifiedIds.find(id) == modifiedIds.end())
+			result.removed.push_back(id);
+		else
+			result.conflicts.push_back(id);
+	}
+
+	//Notes added locally.
+	for (uint64_t id : modifiedIds)
+	{
+		if (baseHashes.find(id) == baseHashes.end() &&
+			remoteHashes.find(id) == remoteHashes.end() && local.find_note(id))
+		{
+			result.pending.push_back(id);
+		}
+	}
+}
+
+void NoteMerge::keepLocal(Result& result)
+{
+	result.pending.insert(result.pending.end(), result.conflicts.begin(), result.conflicts.end());
+	result.conflicts.clear();
+}
+
+void NoteMerge::keepRemote(Result& result, const NoteSet& remote)
+{
+	for (uint64_t id : result.conflicts)
+	{
+		if (remote.find_note(id))
+			result.updated.push_back(id);
+		else
+			result.removed.push_back(id);
+	}
+	result.conflicts.clear();
+}
+
+void NoteMerge::apply(NoteSet& local, const NoteSet& remote, Result& result)
+{
+	NoteSet::Batch batch(local);
+
+	//Duplicated notes in memory move to ids that are free on both sides, taking the notes placed
+	//in them along.
+	std::unordered_map<uint64_t, uint64_t> newIds;
+	for (std::pair<uint64_t, uint64_t>& duplicate : result.duplicates)
+	{
+		do
+			duplicate.second = local.createNote().getId();
+		while (remote.find_note(duplicate.second));
+		newIds.emplace(duplicate.first, duplicate.second);
+		result.pending.push_back(duplicate.second);
+	}
+
+	std::vector<Note> renamedNotes;
+	for (const std::pair<uint64_t, uint64_t>& duplicate : result.duplicates)
+	{
+		const Note* localNote = local.find_note(duplicate.first);
+		Note note(duplicate.second, localNote->getTitle(), localNote->getMessage());
+		std::unordered_map<uint64_t, uint64_t>::const_iterator parentIter =
+			newIds.find(localNote->getParentId());
+		note.setParentId(parentIter == newIds.end() ? localNote->getParentId() :
+			parentIter->second);
+		note.setFolder(localNote->isFolder());
+		renamedNotes.push_back(std::move(note));
+	}
+
+	//Update the notes in a single pass over the notes in memory. Notes that changed between a
+	//note and a folder are replaced instead.
+	std::unordered_set<uint64_t> insertIds(result.updated.begin(), result.updated.end());
+	std::vector<std::pair<uint64_t, uint64_t>> parents;
+	std::vector<uint64_t> eraseIds;
+	for (NoteSet::iterator iter = local.begin(); iter != local.end(); ++iter)
+	{
+		uint64_t id = iter->getId();
+		if (newIds.find(id) != newIds.end())
+		{
+			eraseIds.push_back(id);
+			continue;
+		}
+
+		if (insertIds.find(id) == insertIds.end())
+		{
+			std::unordered_map<uint64_t, uint64_t>::const_iterator parentIter =
+				newIds.find(iter->getParentId());
+			if (parentIter != newIds.end())
+				parents.emplace_back(id, parentIter->second);
+			continue;
+		}
+
+		const Note* remoteNote = remote.find_note(id);
+		if (iter->isFolder() != remoteNote->isFolder())
+		{
+			eraseIds.push_back(id);
+			continue;
+		}
+
+		insertIds.erase(id);
+		if (!(iter->getTitle() == remoteNote->getTitle()))
+			local.setTitle(iter, remoteNote->getTitle());
+		if (!(iter->getMessage() == remoteNote->getMessage()))
+			local.setMessage(iter, remoteNote->getMessage());
+		if (iter->getParentId() != remoteNote->getParentId())
+			local.setParent(iter, remoteNote->getParentId());
+	}
+
+	local.setParents(parents);
+	local.erase(eraseIds);
+	for (Note& note : renamedNotes)
+		local.insert(local.end(), std::move(note));
+	for (uint64_t id : result.updated)
+	{
+		if (insertIds.find(id) != insertIds.end())
+			local.insert(local.end(), *remote.find_note(id));
+	}
+
+	local.erase(result.removed);
+}
+
+} // namespace NoteVault
@@ -0,0 +1,69 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NoteHash.h"
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <cstdint>
+
+namespace NoteVault
+{
+
+class NoteSet;
+
+//Three-way comparison between the notes in memory and a newer version of the same file, such as
+//after it's been changed by another program. The base is the hashes of the notes as they were
+//last loaded from or saved to the file, and local changes since then are tracked by id.
+class NoteMerge
+{
+public:
+	struct Result
+	{
+		//Notes only changed in the file, to copy from there.
+		std::vector<uint64_t> updated;
+
+		//Notes only removed from the file.
+		std::vector<uint64_t> removed;
+
+		//Notes changed both in memory and in the file.
+		std::vector<uint64_t> conflicts;
+
+		//Notes only changed in memory, which still differ from the file.
+		std::vector<uint64_t> pending;
+
+		//Unrelated notes added both in memory and in the file that were given the same id. The
+		//note from the file is added with the id, which is also in updated, while apply() moves
+		//the note in memory to a new id, set as the second id of the pair.
+		std::vector<std::pair<uint64_t, uint64_t>> duplicates;
+	};
+
+	static void diff(Result& result, const NoteSet& local,
+		const std::unordered_set<uint64_t>& modifiedIds, const NoteHash::NoteMap& baseHashes,
+		const NoteHash::NoteMap& remoteHashes);
+
+	//Resolves conflicts in favor of either version.
+	static void keepLocal(Result& result);
+	static void keepRemote(Result& result, const NoteSet& remote);
+
+	//Copies the updated notes from the remote notes and erases the removed notes, reporting all
+	//changes as a single batch. Duplicated notes in memory are given new ids, which are added to
+	//the pending notes.
+	static void apply(NoteSet& local, const NoteSet& remote, Result& result);
+};
+
+} // namespace NoteVault
@@ -1,5 +1,5 @@
 /*
- * Copyright 2015 Aaron Barany
+ * Copyright 2015-2026 Aaron Barany
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -16,26 +16,235 @@
 
 #include "NoteSet.h"
 #include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <unordered_set>
 
 namespace NoteVault
 {
 
+using BlockUsage = std::unordered_map<const TextBlock*, size_t>;
+
+static void addBlockUsage(BlockUsage& usage, const NoteString& string)
+{
+	if (string.isArenaBacked())
+		usage[string.getBlock()] += string.size() + 1;
+}
+
+static void addBlockUsage(BlockUsage& usage, const NoteBody& body)
+{
+	for (size_t i = 0; i < body.getPieceCount(); ++i)
+	{
+		const NoteBody::Piece& piece = body.getPiece(i);
+		usage[piece.block.get()] += piece.size;
+	}
+}
+
+static bool isSparse(const BlockUsage& usage, const TextBlock* curBlock, const TextBlock* block)
+{
+	if (!block || block == curBlock)
+		return false;
+
+	BlockUsage::const_iterator foundIter = usage.find(block);
+	return foundIter != usage.end() && foundIter->second < block->getSize()/2;
+}
+
+static bool isSparse(const BlockUsage& usage, const TextBlock* curBlock, const NoteBody& body)
+{
+	for (size_t i = 0; i < body.getPieceCount(); ++i)
+	{
+		if (isSparse(usage, curBlock, body.getPiece(i).block.get()))
+			return true;
+	}
+	return false;
+}
+
+NoteSet::NoteSet()
+	: m_storageMode(StorageMode::Owned)
+{
+}
+
+void NoteSet::setStorageMode(StorageMode mode)
+{
+	m_storageMode = mode;
+	if (m_storageMode != StorageMode::Arena)
+		m_arena.reset();
+}
+
+NoteArena* NoteSet::getArena()
+{
+	if (m_storageMode != StorageMode::Arena)
+		return nullptr;
+	return &m_arena;
+}
+
+void NoteSet::compact()
+{
+	BlockUsage usage;
+	for (const NoteMap::value_type& notePair : m_notes)
+	{
+		addBlockUsage(usage, notePair.second.getTitle());
+		addBlockUsage(usage, notePair.second.getMessage());
+	}
+
+	if (usage.empty())
+		return;
+
+	//Notes moved out of the arena when not in arena mode are copied to owned storage. Compacting
+	//a message also merges all of its pieces.
+	bool useArena = m_storageMode == StorageMode::Arena;
+	const TextBlock* curBlock = m_arena.getCurrentBlock();
+	for (NoteMap::value_type& notePair : m_notes)
+	{
+		Note& note = notePair.second;
+		const NoteString& title = note.getTitle();
+		if (isSparse(usage, curBlock, title.getBlock()))
+		{
+			if (useArena)
+				note.setTitle(m_arena.copy(title.data(), title.size()));
+			else
+				note.setTitle(title.str());
+			curBlock = m_arena.getCurrentBlock();
+		}
+
+		const NoteBody& message = note.getMessage();
+		if (isSparse(usage, curBlock, message))
+		{
+			if (useArena)
+			{
+				char* data;
+				NoteString messageStr = m_arena.allocate(message.size(), data);
+				for (size_t i = 0; i < message.getPieceCount(); ++i)
+				{
+					const NoteBody::Piece& piece = message.getPiece(i);
+					memcpy(data, piece.data, piece.size);
+					data += piece.size;
+				}
+				note.setMessage(messageStr);
+			}
+			else
+				note.setMessage(message.str());
+			curBlock = m_arena.getCurrentBlock();
+		}
+	}
+}
+
+void NoteSet::addListener(NoteSetListener* listener)
+{
+	m_observers.listeners.push_back(listener);
+}
+
+void NoteSet::removeListener(NoteSetListener* listener)
+{
+	std::vector<NoteSetListener*>& listeners = m_observers.listeners;
+	listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+}
+
+void NoteSet::beginBatch()
+{
+	++m_observers.batchDepth;
+}
+
+void NoteSet::endBatch()
+{
+	assert(m_observers.batchDepth > 0);
+	if (--m_observers.batchDepth > 0 || m_observers.pendingChanges.empty())
+		return;
+
+	std::vector<NoteChange> changes;
+	changes.swap(m_observers.pendingChanges);
+	//Copy the listeners in case they're modified during the callbacks.
+	std::vector<NoteSetListener*> listeners = m_observers.listeners;
+	for (NoteSetListener* listener : listeners)
+		listener->notesChanged(*this, changes);
+}
+
+void NoteSet::setTitle(const iterator& iter, NoteString title)
+{
+	iter->setTitle(std::move(title));
+	notify(NoteChange::Type::TitleChanged, iter->getId(), iter.m_iter - m_order.begin());
+}
+
+void NoteSet::setMessage(const iterator& iter, NoteBody message)
+{
+	iter->setMessage(std::move(message));
+	notify(NoteChange::Type::MessageChanged, iter->getId(), iter.m_iter - m_order.begin());
+}
+
+void NoteSet::replaceMessage(const iterator& iter, size_t offset, size_t length, const char* data,
+	size_t dataLength)
+{
+	iter->replaceMessage(offset, length, data, dataLength);
+	notify(NoteChange::Type::MessageChanged, iter->getId(), iter.m_iter - m_order.begin());
+}
+
+void NoteSet::setParent(const iterator& iter, uint64_t parentId)
+{
+	iter->setParentId(parentId);
+	notify(NoteChange::Type::ParentChanged, iter->getId(), iter.m_iter - m_order.begin());
+}
+
+size_t NoteSet::setParents(const std::vector<std::pair<uint64_t, uint64_t>>& parents)
+{
+	std::unordered_map<uint64_t, uint64_t> parentIds(parents.begin(), parents.end());
+	Batch batch(*this);
+
+	size_t moved = 0;
+	for (OrderList::iterator iter = m_order.begin(); iter != m_order.end(); ++iter)
+	{
+		std::unordered_map<uint64_t, uint64_t>::const_iterator foundIter = parentIds.find(*iter);
+		if (foundIter == parentIds.end())
+			continue;
+
+		m_notes.find(*iter)->second.setParentId(foundIter->second);
+		notify(NoteChange::Type::ParentChanged, *iter, iter - m_order.begin());
+		++moved;
+	}
+	return moved;
+}
+
+Note NoteSet::createNote()
+{
+	uint64_t id = m_ids.newId();
+	m_ids.removeId(id);
+	return Note(id);
+}
+
 NoteSet::iterator NoteSet::insert(const iterator& pos)
 {
 	uint64_t id = m_ids.newId();
-	Note note(id);
-	m_notes.insert(NoteMap::value_type(id, note));
+	m_notes.emplace(std::piecewise_construct, std::forward_as_tuple(id),
+		std::forward_as_tuple(id));
 	OrderList::iterator orderPos = m_order.insert(pos.m_iter, id);
-	return iterator(*this, orderPos);
+	size_t index = orderPos - m_order.begin();
+	updatePositions(index);
+	notify(NoteChange::Type::Inserted, id, index);
+	return iterator(*this, m_order.begin() + index);
 }
 
 NoteSet::iterator NoteSet::insert(const iterator& pos, const Note& note)
 {
 	if (!m_ids.addId(note.getId()))
 		return end();
-	m_notes.insert(NoteMap::value_type(note.getId(), note));
+	m_notes.emplace(note.getId(), note);
 	OrderList::iterator orderPos = m_order.insert(pos.m_iter, note.getId());
-	return iterator(*this, orderPos);
+	size_t index = orderPos - m_order.begin();
+	updatePositions(index);
+	notify(NoteChange::Type::Inserted, note.getId(), index);
+	return iterator(*this, m_order.begin() + index);
+}
+
+NoteSet::iterator NoteSet::insert(const iterator& pos, Note&& note)
+{
+	uint64_t id = note.getId();
+	if (!m_ids.addId(id))
+		return end();
+	m_notes.emplace(id, std::move(note));
+	OrderList::iterator orderPos = m_order.insert(pos.m_iter, id);
+	size_t index = orderPos - m_order.begin();
+	updatePositions(index);
+	notify(NoteChange::Type::Inserted, id, index);
+	return iterator(*this, m_order.begin() + index);
 }
 
 int NoteSet::erase(uint64_t id)
@@ -49,26 +258,62 @@ int NoteSet::erase(uint64_t id)
 
 NoteSet::iterator NoteSet::erase(const iterator& iter)
 {
-	m_ids.removeId(iter->getId());
-	m_notes.erase(iter->getId());
-	OrderList::iterator newIter = m_order.erase(iter.m_iter);
-	return iterator(*this, newIter);
+	uint64_t id = iter->getId();
+	m_ids.removeId(id);
+	m_notes.erase(id);
+	m_positions.erase(id);
+	size_t index = m_order.erase(iter.m_iter) - m_order.begin();
+	updatePositions(index);
+	notify(NoteChange::Type::Removed, id, index);
+	return iterator(*this, m_order.begin() + index);
+}
+
+size_t NoteSet::erase(const std::vector<uint64_t>& ids)
+{
+	std::unordered_set<uint64_t> eraseIds(ids.begin(), ids.end());
+	Batch batch(*this);
+
+	//Indices are reported as if the notes were erased one at a time from the front.
+	size_t erased = 0;
+	size_t firstErased = m_order.size();
+	OrderList::iterator dest = m_order.begin();
+	for (OrderList::iterator iter = m_order.begin(); iter != m_order.end(); ++iter)
+	{
+		uint64_t id = *iter;
+		if (eraseIds.count(id) == 0)
+		{
+			*dest++ = id;
+			continue;
+		}
+
+		m_ids.removeId(id);
+		m_notes.erase(id);
+		m_positions.erase(id);
+		if (erased == 0)
+			firstErased = iter - m_order.begin();
+		notify(NoteChange::Type::Removed, id, iter - m_order.begin() - erased);
+		++erased;
+	}
+
+	m_order.erase(dest, m_order.end());
+	updatePositions(firstErased);
+	return erased;
 }
 
 NoteSet::iterator NoteSet::find(uint64_t id)
 {
-	OrderList::iterator foundIter = std::find(m_order.begin(), m_order.end(), id);
-	if (foundIter == m_order.end())
+	PositionMap::const_iterator foundIter = m_positions.find(id);
+	if (foundIter == m_positions.end())
 		return end();
-	return iterator(*this, foundIter);
+	return iterator(*this, m_order.begin() + foundIter->second);
 }
 
 NoteSet::const_iterator NoteSet::find(uint64_t id) const
 {
-	OrderList::const_iterator foundIter = std::find(m_order.begin(), m_order.end(), id);
-	if (foundIter == m_order.end())
+	PositionMap::const_iterator foundIter = m_positions.find(id);
+	if (foundIter == m_positions.end())
 		return end();
-	return const_iterator(*this, foundIter);
+	return const_iterator(*this, m_order.begin() + foundIter->second);
 }
 
 Note* NoteSet::find_note(uint64_t id)
@@ -91,7 +336,10 @@ void NoteSet::clear()
 {
 	m_notes.clear();
 	m_order.clear();
+	m_positions.clear();
 	m_ids.clear();
+	m_arena.reset();
+	notify(NoteChange::Type::Reset, NoteChange::cNoId, 0);
 }
 
 Note& NoteSet::operator[](size_t index)
@@ -124,4 +372,24 @@ NoteSet::iterator NoteSet::end()
 	return iterator(*this, m_order.end());
 }
 
+void NoteSet::notify(NoteChange::Type type, uint64_t id, size_t index, size_t oldIndex)
+{
+	if (m_observers.listeners.empty())
+		return;
+
+	NoteChange change = {type, id, index, oldIndex};
+	m_observers.pendingChanges.push_back(change);
+	if (m_observers.batchDepth == 0)
+	{
+		++m_observers.batchDepth;
+		endBatch();
+	}
+}
+
+void NoteSet::updatePositions(size_t first)
+{
+	for (size_t i = first; i < m_order.size(); ++i)
+		m_positions[m_order[i]] = i;
+}
+
 } // namespace NoteVault
@@ -16,11 +16,15 @@
  */
 
 #include "Note.h"
+#include "NoteArena.h"
+#include "NoteSetListener.h"
 #include "IdFactory.h"
 #include <unordered_map>
 #include <vector>
 #include <iterator>
 #include <algorithm>
+#include <tuple>
+#include <utility>
 
 namespace NoteVault
 {
@@ -30,14 +34,62 @@ class NoteSet
 public:
 	class iterator;
 	class const_iterator;
+	class Batch;
+
+	enum class StorageMode
+	{
+		Owned,
+		Arena
+	};
+
+	NoteSet();
+
+	StorageMode getStorageMode() const	{return m_storageMode;}
+	void setStorageMode(StorageMode mode);
+
+	//Returns the arena for loading note text, or null if not in arena storage mode.
+	NoteArena* getArena();
+
+	//Moves text out of sparsely used arena blocks so they can be freed.
+	void compact();
+
+	//Listeners aren't copied or moved with the notes. Changes made through the iterators or
+	//index operators aren't reported; use the setters below.
+	void addListener(NoteSetListener* listener);
+	void removeListener(NoteSetListener* listener);
+
+	//Collects changes until the outermost batch ends, then reports them together.
+	void beginBatch();
+	void endBatch();
+
+	void setTitle(const iterator& iter, NoteString title);
+	void setMessage(const iterator& iter, NoteBody message);
+	void replaceMessage(const iterator& iter, size_t offset, size_t length, const char* data,
+		size_t dataLength);
+	void setParent(const iterator& iter, uint64_t parentId);
+
+	//Moves many notes to new folders in a single pass, reporting the changes as a single batch.
+	//Each pair is the id of a note and its new folder.
+	size_t setParents(const std::vector<std::pair<uint64_t, uint64_t>>& parents);
+
+	//Creates a note with an unused id without adding it to the set.
+	Note createNote();
 
 	iterator insert(const iterator& pos);
 	iterator insert(const iterator& pos, const Note& note);
+	iterator insert(const iterator& pos, Note&& note);
+
+	template <typename... Args>
+	iterator emplace(const iterator& pos, uint64_t id, Args&&... args);
 
 	int erase(uint64_t id);
 	int erase(const Note& note)	{return erase(note.getId());}
 	iterator erase(const iterator& iter);
 
+	//Erases many notes in a single pass, reporting the changes as a single batch.
+	size_t erase(const std::vector<uint64_t>& ids);
+
+	//Both lookups by id are constant time. find() also gives the position of the note.
 	iterator find(uint64_t id);
 	const_iterator find(uint64_t id) const;
 
@@ -59,13 +111,66 @@ public:
 	template <typename Pred>
 	void sort(const Pred& pred);
 
+	//Moves a single note to its sorted position, assuming all other notes are already sorted.
+	template <typename Pred>
+	iterator sortNote(const iterator& iter, const Pred& pred);
+
+	//Merges notes that are sorted by pred into a set that's already sorted, moving them out of the
+	//list. Notes with ids already in the set are skipped. Returns the number of notes inserted.
+	template <typename Pred>
+	size_t insertSorted(std::vector<Note>& notes, const Pred& pred);
+
 private:
 	using NoteMap = std::unordered_map<uint64_t, Note>;
 	using OrderList = std::vector<uint64_t>;
+	using PositionMap = std::unordered_map<uint64_t, size_t>;
+
+	struct Observers
+	{
+		Observers()
+			: batchDepth(0) {}
+		Observers(const Observers&)
+			: batchDepth(0) {}
+		Observers& operator=(const Observers&)	{return *this;}
+
+		std::vector<NoteSetListener*> listeners;
+		std::vector<NoteChange> pendingChanges;
+		unsigned int batchDepth;
+	};
+
+	void notify(NoteChange::Type type, uint64_t id, size_t index, size_t oldIndex = 0);
+
+	//Updates the positions of the notes from first to the end of the order.
+	void updatePositions(size_t first);
 
 	NoteMap m_notes;
 	OrderList m_order;
+	PositionMap m_positions;
 	IdFactory m_ids;
+	StorageMode m_storageMode;
+	NoteArena m_arena;
+	Observers m_observers;
+};
+
+class NoteSet::Batch
+{
+public:
+	explicit Batch(NoteSet& notes)
+		: m_notes(notes)
+	{
+		m_notes.beginBatch();
+	}
+
+	~Batch()
+	{
+		m_notes.endBatch();
+	}
+
+private:
+	Batch(const Batch&) = delete;
+	Batch& operator=(const Batch&) = delete;
+
+	NoteSet& m_notes;
 };
 
 class NoteSet::iterator
@@ -162,6 +267,20 @@ private:
 	const Note* m_curNote;
 };
 
+template <typename... Args>
+NoteSet::iterator NoteSet::emplace(const iterator& pos, uint64_t id, Args&&... args)
+{
+	if (!m_ids.addId(id))
+		return end();
+	m_notes.emplace(std::piecewise_construct, std::forward_as_tuple(id),
+		std::forward_as_tuple(id, std::forward<Args>(args)...));
+	OrderList::iterator orderPos = m_order.insert(pos.m_iter, id);
+	size_t index = orderPos - m_order.begin();
+	updatePositions(index);
+	notify(NoteChange::Type::Inserted, id, index);
+	return iterator(*this, m_order.begin() + index);
+}
+
 template <typename Pred>
 void NoteSet::sort(const Pred& pred)
 {
@@ -169,6 +288,92 @@ void NoteSet::sort(const Pred& pred)
 		{
 			return pred(m_notes.find(left)->second, m_notes.find(right)->second);
 		});
+	updatePositions(0);
+	notify(NoteChange::Type::Reordered, NoteChange::cNoId, 0);
+}
+
+template <typename Pred>
+NoteSet::iterator NoteSet::sortNote(const iterator& iter, const Pred& pred)
+{
+	auto compare = [this, &pred] (uint64_t left, uint64_t right) -> bool
+		{
+			return pred(m_notes.find(left)->second, m_notes.find(right)->second);
+		};
+
+	OrderList::iterator curPos = iter.m_iter;
+	uint64_t id = *curPos;
+	OrderList::iterator newPos;
+	if (curPos != m_order.begin() && compare(id, *(curPos - 1)))
+	{
+		newPos = std::upper_bound(m_order.begin(), curPos, id, compare);
+		std::rotate(newPos, curPos, curPos + 1);
+		for (OrderList::iterator posIter = newPos; posIter != curPos + 1; ++posIter)
+			m_positions[*posIter] = posIter - m_order.begin();
+	}
+	else if (curPos + 1 != m_order.end() && compare(*(curPos + 1), id))
+	{
+		newPos = std::lower_bound(curPos + 1, m_order.end(), id, compare) - 1;
+		std::rotate(curPos, curPos + 1, newPos + 1);
+		for (OrderList::iterator posIter = curPos; posIter != newPos + 1; ++posIter)
+			m_positions[*posIter] = posIter - m_order.begin();
+	}
+	else
+		return iter;
+
+	notify(NoteChange::Type::Moved, id, newPos - m_order.begin(), curPos - m_order.begin());
+	return iterator(*this, newPos);
+}
+
+template <typename Pred>
+size_t NoteSet::insertSorted(std::vector<Note>& notes, const Pred& pred)
+{
+	size_t oldSize = m_order.size();
+	for (Note& note : notes)
+	{
+		uint64_t id = note.getId();
+		if (!m_ids.addId(id))
+			continue;
+		m_notes.emplace(id, std::move(note));
+		m_order.push_back(id);
+	}
+
+	size_t inserted = m_order.size() - oldSize;
+	if (inserted == 0)
+		return 0;
+
+	auto compare = [this, &pred] (uint64_t left, uint64_t right) -> bool
+		{
+			return pred(m_notes.find(left)->second, m_notes.find(right)->second);
+		};
+
+	//Merge by hand to know where each new note ends up. Existing notes stay first among equals.
+	OrderList::const_iterator middle = m_order.begin() + oldSize;
+	OrderList::const_iterator oldIter = m_order.begin();
+	OrderList::const_iterator newIter = middle;
+	OrderList merged;
+	merged.reserve(m_order.size());
+	std::vector<size_t> insertedIndices;
+	insertedIndices.reserve(inserted);
+	while (oldIter != middle || newIter != m_order.end())
+	{
+		if (newIter != m_order.end() && (oldIter == middle || compare(*newIter, *oldIter)))
+		{
+			insertedIndices.push_back(merged.size());
+			merged.push_back(*newIter++);
+		}
+		else
+			merged.push_back(*oldIter++);
+	}
+	m_order.swap(merged);
+	updatePositions(0);
+
+	//Reported in order of the final positions, so each index is correct when the insertions are
+	//applied one at a time.
+	beginBatch();
+	for (size_t index : insertedIndices)
+		notify(NoteChange::Type::Inserted, m_order[index], index);
+	endBatch();
+	return inserted;
 }
 
 inline NoteSet::iterator::iterator()
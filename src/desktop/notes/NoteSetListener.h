@@ -0,0 +1,58 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace NoteVault
+{
+
+class NoteSet;
+
+struct NoteChange
+{
+	enum class Type
+	{
+		Inserted,       //index is the new position
+		Removed,        //index is the position before removal
+		TitleChanged,
+		MessageChanged,
+		ParentChanged,  //moved to a different folder
+		Moved,          //index is the new position, oldIndex the position before the move
+		Reordered,      //the order of all notes may have changed; no id or index
+		Reset           //the set was cleared; no id or index
+	};
+
+	static const uint64_t cNoId = static_cast<uint64_t>(-1);
+
+	Type type;
+	uint64_t id;
+	size_t index;
+	size_t oldIndex;
+};
+
+class NoteSetListener
+{
+public:
+	virtual ~NoteSetListener() = default;
+
+	//Changes are in the order they were made. Outside of a batch this is a single change.
+	virtual void notesChanged(NoteSet& notes, const std::vector<NoteChange>& changes) = 0;
+};
+
+} // namespace NoteVault
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NoteSnapshot.h"
+#include "NoteSet.h"
+
+namespace NoteVault
+{
+
+NoteSnapshotter::NoteSnapshotter()
+	: m_orderChanged(true)
+{
+}
+
+NoteSnapshotter::~NoteSnapshotter()
+{
+}
+
+NoteSnapshot NoteSnapshotter::take(const NoteSet& notes)
+{
+	if (!m_notes || m_orderChanged)
+		rebuild(notes);
+	else if (!m_changedIds.empty())
+	{
+		//Copy the list if a save in progress is still reading it.
+		if (m_notes.use_count() > 1)
+			m_notes = std::make_shared<NoteSnapshot::NoteList>(*m_notes);
+
+		for (uint64_t id : m_changedIds)
+		{
+			const Note* note = notes.find_note(id);
+			std::unordered_map<uint64_t, size_t>::const_iterator indexIter = m_indices.find(id);
+			if (!note || indexIter == m_indices.end())
+			{
+				rebuild(notes);
+				break;
+			}
+
+			(*m_notes)[indexIter->second] = std::make_shared<const Note>(*note);
+		}
+	}
+
+	m_changedIds.clear();
+	m_orderChanged = false;
+	return NoteSnapshot(m_notes);
+}
+
+void NoteSnapshotter::clear()
+{
+	m_notes.reset();
+	std::unordered_map<uint64_t, size_t>().swap(m_indices);
+	std::unordered_set<uint64_t>().swap(m_changedIds);
+	m_orderChanged = true;
+}
+
+void NoteSnapshotter::notesChanged(NoteSet&, const std::vector<NoteChange>& changes)
+{
+	for (const NoteChange& change : changes)
+	{
+		switch (change.type)
+		{
+			case NoteChange::Type::Inserted:
+				//The id may have been used by a note that was removed.
+				m_changedIds.insert(change.id);
+				m_orderChanged = true;
+				break;
+			case NoteChange::Type::TitleChanged:
+			case NoteChange::Type::MessageChanged:
+			case NoteChange::Type::ParentChanged:
+				m_changedIds.insert(change.id);
+				break;
+			case NoteChange::Type::Removed:
+			case NoteChange::Type::Moved:
+			case NoteChange::Type::Reordered:
+				m_orderChanged = true;
+				break;
+			case NoteChange::Type::Reset:
+				clear();
+				break;
+		}
+	}
+}
+
+void NoteSnapshotter::rebuild(const NoteSet& notes)
+{
+	//Notes copied for earlier snapshots are kept unless they changed since. The indices are
+	//updated in place so only new notes add entries.
+	std::shared_ptr<NoteSnapshot::NoteList> newNotes =
+		std::make_shared<NoteSnapshot::NoteList>();
+	newNotes->reserve(notes.size());
+	for (const Note& note : notes)
+	{
+		uint64_t id = note.getId();
+		size_t index = newNotes->size();
+		std::pair<std::unordered_map<uint64_t, size_t>::iterator, bool> inserted =
+			m_indices.emplace(id, index);
+		if (!inserted.second && m_changedIds.find(id) == m_changedIds.end())
+			newNotes->push_back((*m_notes)[inserted.first->second]);
+		else
+			newNotes->push_back(std::make_shared<const Note>(note));
+		inserted.first->second = index;
+	}
+
+	//Forget the notes that were removed.
+	if (m_indices.size() > newNotes->size())
+	{
+		for (std::unordered_map<uint64_t, size_t>::iterator iter = m_indices.begin();
+			iter != m_indices.end();)
+		{
+			if (iter->second >= newNotes->size() ||
+				(*newNotes)[iter->second]->getId() != iter->first)
+			{
+				iter = m_indices.erase(iter);
+			}
+			else
+				++iter;
+		}
+	}
+
+	m_notes = std::move(newNotes);
+}
+
+} // namespace NoteVault
@@ -0,0 +1,116 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Note.h"
+#include "NoteSetListener.h"
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace NoteVault
+{
+
+//Read-only copy of the notes in a NoteSet, in the same order, that can be read from another
+//thread. Notes are shared between snapshots, so a snapshot only copies pointers to the notes.
+class NoteSnapshot
+{
+public:
+	using NoteList = std::vector<std::shared_ptr<const Note>>;
+
+	class const_iterator;
+
+	NoteSnapshot()	{}
+	explicit NoteSnapshot(std::shared_ptr<const NoteList> notes)
+		: m_notes(std::move(notes)) {}
+
+	size_t size() const	{return m_notes ? m_notes->size() : 0;}
+	bool empty() const	{return size() == 0;}
+
+	const_iterator begin() const;
+	const_iterator end() const;
+
+private:
+	std::shared_ptr<const NoteList> m_notes;
+};
+
+class NoteSnapshot::const_iterator
+{
+public:
+	using iterator_category = std::forward_iterator_tag;
+	using value_type = Note;
+	using difference_type = std::ptrdiff_t;
+	using pointer = const Note*;
+	using reference = const Note&;
+
+	const_iterator()	{}
+	explicit const_iterator(NoteList::const_iterator iter)
+		: m_iter(iter) {}
+
+	const Note& operator*() const	{return **m_iter;}
+	const Note* operator->() const	{return m_iter->get();}
+
+	const_iterator& operator++()	{++m_iter; return *this;}
+	const_iterator operator++(int)	{const_iterator prev = *this; ++m_iter; return prev;}
+
+	bool operator==(const const_iterator& other) const	{return m_iter == other.m_iter;}
+	bool operator!=(const const_iterator& other) const	{return m_iter != other.m_iter;}
+
+private:
+	NoteList::const_iterator m_iter;
+};
+
+inline NoteSnapshot::const_iterator NoteSnapshot::begin() const
+{
+	return m_notes ? const_iterator(m_notes->begin()) : const_iterator();
+}
+
+inline NoteSnapshot::const_iterator NoteSnapshot::end() const
+{
+	return m_notes ? const_iterator(m_notes->end()) : const_iterator();
+}
+
+//Takes snapshots of a NoteSet, copying only the notes that changed since the last snapshot. The
+//list of notes is updated in place when no earlier snapshot still uses it, and is rebuilt from
+//the notes already copied when notes are added, removed, or reordered.
+class NoteSnapshotter : public NoteSetListener
+{
+public:
+	NoteSnapshotter();
+	~NoteSnapshotter();
+
+	NoteSnapshot take(const NoteSet& notes);
+
+	//Forgets the copied notes, such as when the notes are replaced without reporting changes.
+	void clear();
+
+	void notesChanged(NoteSet& notes, const std::vector<NoteChange>& changes) override;
+
+private:
+	NoteSnapshotter(const NoteSnapshotter&) = delete;
+	NoteSnapshotter& operator=(const NoteSnapshotter&) = delete;
+
+	void rebuild(const NoteSet& notes);
+
+	std::shared_ptr<NoteSnapshot::NoteList> m_notes;
+	std::unordered_map<uint64_t, size_t> m_indices;
+	std::unordered_set<uint64_t> m_changedIds;
+	bool m_orderChanged;
+};
+
+} // namespace NoteVault
@@ -0,0 +1,109 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TextBlock.h"
+#include <memory>
+#include <string>
+#include <cstring>
+
+namespace NoteVault
+{
+
+//Immutable string that either owns its text or references a null-terminated range of a shared
+//TextBlock. Assigning new text always switches to owned storage. Owned text is cleansed before
+//it's released.
+class NoteString
+{
+public:
+	NoteString()
+		: m_data(nullptr), m_size(0) {}
+	NoteString(std::string str)
+		: m_owned(std::move(str)), m_data(nullptr), m_size(0) {}
+	NoteString(const char* str)
+		: m_owned(str), m_data(nullptr), m_size(0) {}
+	NoteString(std::shared_ptr<const TextBlock> block, const char* data, size_t size)
+		: m_block(std::move(block)), m_data(data), m_size(size) {}
+	NoteString(const NoteString& other) = default;
+	NoteString(NoteString&& other) = default;
+	~NoteString()	{cleanseOwned();}
+
+	NoteString& operator=(const NoteString& other);
+	NoteString& operator=(NoteString&& other);
+
+	const char* data() const	{return m_block ? m_data : m_owned.c_str();}
+	const char* c_str() const	{return data();}
+	size_t size() const	{return m_block ? m_size : m_owned.size();}
+	bool empty() const	{return size() == 0;}
+	std::string str() const	{return std::string(data(), size());}
+
+	bool isArenaBacked() const	{return m_block != nullptr;}
+	const TextBlock* getBlock() const	{return m_block.get();}
+	const std::shared_ptr<const TextBlock>& getSharedBlock() const	{return m_block;}
+
+	bool operator==(const NoteString& other) const;
+	bool operator!=(const NoteString& other) const	{return !(*this == other);}
+
+private:
+	void cleanseOwned();
+
+	std::string m_owned;
+	std::shared_ptr<const TextBlock> m_block;
+	const char* m_data;
+	size_t m_size;
+};
+
+inline void NoteString::cleanseOwned()
+{
+	//Clear the full capacity, since a string that was moved from may still hold its old text.
+	//Resizing first makes all of it part of the string so it may be written to.
+	m_owned.resize(m_owned.capacity());
+	TextBlock::cleanse(&m_owned[0], m_owned.size());
+	m_owned.clear();
+}
+
+inline NoteString& NoteString::operator=(const NoteString& other)
+{
+	if (this == &other)
+		return *this;
+
+	cleanseOwned();
+	m_owned = other.m_owned;
+	m_block = other.m_block;
+	m_data = other.m_data;
+	m_size = other.m_size;
+	return *this;
+}
+
+inline NoteString& NoteString::operator=(NoteString&& other)
+{
+	if (this == &other)
+		return *this;
+
+	cleanseOwned();
+	m_owned = std::move(other.m_owned);
+	m_block = std::move(other.m_block);
+	m_data = other.m_data;
+	m_size = other.m_size;
+	return *this;
+}
+
+inline bool NoteString::operator==(const NoteString& other) const
+{
+	return size() == other.size() && memcmp(data(), other.data(), size()) == 0;
+}
+
+} // namespace NoteVault
@@ -0,0 +1,270 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NoteTree.h"
+#include "NoteSet.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#define strcasecmp _stricmp
+#else
+#include <strings.h>
+#endif
+
+namespace NoteVault
+{
+
+const size_t NoteTree::cNotFound;
+
+NoteTree::Node::Node()
+	: parentId(Note::cNoParent), attached(false)
+{
+}
+
+bool NoteTree::compare(const Note& left, const Note& right)
+{
+	if (left.isFolder() != right.isFolder())
+		return left.isFolder();
+
+	int titleOrder = strcasecmp(left.getTitle().c_str(), right.getTitle().c_str());
+	if (titleOrder != 0)
+		return titleOrder < 0;
+	return left.getId() < right.getId();
+}
+
+void NoteTree::findUnrooted(std::vector<uint64_t>& ids, const NoteSet& notes)
+{
+	//Follow the folders above each note until reaching the root or a note that was already
+	//checked. Reaching a note from the current path again means the folders loop.
+	enum class State
+	{
+		Visiting,
+		Rooted
+	};
+
+	std::unordered_map<uint64_t, State> states;
+	std::vector<uint64_t> path;
+	for (const Note& note : notes)
+	{
+		path.clear();
+		const Note* curNote = &note;
+		while (true)
+		{
+			uint64_t id = curNote->getId();
+			std::unordered_map<uint64_t, State>::const_iterator foundState = states.find(id);
+			if (foundState != states.end())
+			{
+				if (foundState->second == State::Visiting)
+					ids.push_back(id);
+				break;
+			}
+
+			states.emplace(id, State::Visiting);
+			path.push_back(id);
+
+			uint64_t parentId = curNote->getParentId();
+			if (parentId == Note::cNoParent)
+				break;
+
+			const Note* parent = notes.find_note(parentId);
+			if (!parent || !parent->isFolder())
+			{
+				ids.push_back(id);
+				break;
+			}
+			curNote = parent;
+		}
+
+		for (uint64_t id : path)
+			states[id] = State::Rooted;
+	}
+}
+
+void NoteTree::build(const NoteSet& notes)
+{
+	m_nodes.clear();
+	m_nodes.reserve(notes.size() + 1);
+	m_nodes[Note::cNoParent].attached = true;
+	for (const Note& note : notes)
+	{
+		Node& node = m_nodes[note.getId()];
+		node.parentId = note.getParentId();
+		node.attached = true;
+		m_nodes[note.getParentId()].children.push_back(note.getId());
+	}
+
+	auto compareIds = [&notes] (uint64_t left, uint64_t right) -> bool
+		{
+			return compare(*notes.find_note(left), *notes.find_note(right));
+		};
+	for (NodeMap::value_type& nodePair : m_nodes)
+	{
+		ChildList& children = nodePair.second.children;
+		std::sort(children.begin(), children.end(), compareIds);
+	}
+}
+
+void NoteTree::clear()
+{
+	m_nodes.clear();
+}
+
+bool NoteTree::contains(uint64_t id) const
+{
+	if (id == Note::cNoParent)
+		return true;
+
+	NodeMap::const_iterator foundNode = m_nodes.find(id);
+	return foundNode != m_nodes.end() && foundNode->second.attached;
+}
+
+bool NoteTree::isReachable(uint64_t id) const
+{
+	//Folders that loop back on themselves never reach the root.
+	for (size_t i = 0; i <= m_nodes.size(); ++i)
+	{
+		if (id == Note::cNoParent)
+			return true;
+
+		NodeMap::const_iterator foundNode = m_nodes.find(id);
+		if (foundNode == m_nodes.end() || !foundNode->second.attached)
+			return false;
+		id = foundNode->second.parentId;
+	}
+
+	return false;
+}
+
+uint64_t NoteTree::getParent(uint64_t id) const
+{
+	NodeMap::const_iterator foundNode = m_nodes.find(id);
+	if (foundNode == m_nodes.end())
+		return Note::cNoParent;
+	return foundNode->second.parentId;
+}
+
+const NoteTree::ChildList& NoteTree::getChildren(uint64_t parentId) const
+{
+	static const ChildList emptyList;
+	NodeMap::const_iterator foundNode = m_nodes.find(parentId);
+	if (foundNode == m_nodes.end())
+		return emptyList;
+	return foundNode->second.children;
+}
+
+const uint64_t* NoteTree::findId(uint64_t id) const
+{
+	NodeMap::const_iterator foundNode = m_nodes.find(id);
+	if (foundNode == m_nodes.end())
+		return nullptr;
+	return &foundNode->first;
+}
+
+size_t NoteTree::indexOf(const NoteSet& notes, uint64_t id) const
+{
+	NodeMap::const_iterator foundNode = m_nodes.find(id);
+	if (foundNode == m_nodes.end() || !foundNode->second.attached)
+		return cNotFound;
+
+	//The list may be part way through being updated, such as when a note was renamed or removed
+	//from the set but not yet moved in the tree.
+	const ChildList& children = getChildren(foundNode->second.parentId);
+	if (const Note* note = notes.find_note(id))
+	{
+		size_t begin = 0;
+		size_t end = children.size();
+		bool sorted = true;
+		while (begin < end)
+		{
+			size_t middle = begin + (end - begin)/2;
+			const Note* middleNote = notes.find_note(children[middle]);
+			if (!middleNote)
+			{
+				sorted = false;
+				break;
+			}
+
+			if (compare(*middleNote, *note))
+				begin = middle + 1;
+			else
+				end = middle;
+		}
+
+		if (sorted && begin < children.size() && children[begin] == id)
+			return begin;
+	}
+
+	ChildList::const_iterator foundChild = std::find(children.begin(), children.end(), id);
+	if (foundChild == children.end())
+		return cNotFound;
+	return foundChild - children.begin();
+}
+
+size_t NoteTree::findInsertIndex(const NoteSet& notes, const Note& note) const
+{
+	const ChildList& children = getChildren(note.getParentId());
+	return std::lower_bound(children.begin(), children.end(), note,
+		[&notes] (uint64_t id, const Note& value) -> bool
+		{
+			return compare(*notes.find_note(id), value);
+		}) - children.begin();
+}
+
+void NoteTree::insert(uint64_t id, uint64_t parentId, size_t index)
+{
+	Node& node = m_nodes[id];
+	node.parentId = parentId;
+	node.attached = true;
+
+	ChildList& children = m_nodes[parentId].children;
+	children.insert(children.begin() + index, id);
+}
+
+size_t NoteTree::remove(uint64_t id)
+{
+	NodeMap::iterator foundNode = m_nodes.find(id);
+	if (foundNode == m_nodes.end() || !foundNode->second.attached)
+		return cNotFound;
+
+	foundNode->second.attached = false;
+	ChildList& children = m_nodes[foundNode->second.parentId].children;
+	ChildList::iterator foundChild = std::find(children.begin(), children.end(), id);
+	size_t index = foundChild - children.begin();
+	children.erase(foundChild);
+	return index;
+}
+
+void NoteTree::erase(uint64_t id)
+{
+	//Notes still placed in the note keep it around until they're moved or removed as well.
+	NodeMap::iterator foundNode = m_nodes.find(id);
+	if (foundNode != m_nodes.end() && !foundNode->second.attached &&
+		foundNode->second.children.empty())
+	{
+		m_nodes.erase(foundNode);
+	}
+}
+
+void NoteTree::getDescendants(std::vector<uint64_t>& ids, uint64_t id) const
+{
+	for (uint64_t childId : getChildren(id))
+	{
+		ids.push_back(childId);
+		getDescendants(ids, childId);
+	}
+}
+
+} // namespace NoteVault
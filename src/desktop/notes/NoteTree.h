@@ -0,0 +1,98 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace NoteVault
+{
+
+class Note;
+class NoteSet;
+
+//Children of each folder, sorted with folders first and then by title. This is kept apart from the
+//order of the NoteSet so adding or renaming a note only touches the list for its folder. Notes
+//placed in a folder that isn't in the tree are kept until it's added, but can't be reached from
+//the root until then.
+class NoteTree
+{
+public:
+	using ChildList = std::vector<uint64_t>;
+
+	static const size_t cNotFound = static_cast<size_t>(-1);
+
+	//Order of notes within a folder. Ties are broken by id so each note has a unique position.
+	static bool compare(const Note& left, const Note& right);
+
+	//Adds the notes that can't be reached from the root since their folder is missing, isn't a
+	//folder, or is inside of the note itself. Moving these notes to the root fixes the tree.
+	static void findUnrooted(std::vector<uint64_t>& ids, const NoteSet& notes);
+
+	void build(const NoteSet& notes);
+	void clear();
+
+	//Returns true if the note is in the list for its folder.
+	bool contains(uint64_t id) const;
+
+	//Returns true if the note and all of its folders are in the tree.
+	bool isReachable(uint64_t id) const;
+
+	uint64_t getParent(uint64_t id) const;
+	const ChildList& getChildren(uint64_t parentId) const;
+
+	//Returns the address of the id stored in the tree, which stays the same until the note is
+	//erased.
+	const uint64_t* findId(uint64_t id) const;
+
+	//Finds the index of a note within its folder. This is a binary search while the notes in the
+	//folder are sorted, falling back to a linear search otherwise.
+	size_t indexOf(const NoteSet& notes, uint64_t id) const;
+
+	//Index to insert a note at to keep the notes of its folder sorted. The other notes in the folder
+	//must be sorted.
+	size_t findInsertIndex(const NoteSet& notes, const Note& note) const;
+
+	void insert(uint64_t id, uint64_t parentId, size_t index);
+
+	//Removes a note from the list for its folder, returning its index. The notes placed in it are
+	//kept in case it's inserted again.
+	size_t remove(uint64_t id);
+
+	//Forgets a removed note once it's no longer in the set.
+	void erase(uint64_t id);
+
+	//Adds the ids of every note below the note, with folders before their contents.
+	void getDescendants(std::vector<uint64_t>& ids, uint64_t id) const;
+
+private:
+	struct Node
+	{
+		Node();
+
+		uint64_t parentId;
+		bool attached;
+		ChildList children;
+	};
+
+	using NodeMap = std::unordered_map<uint64_t, Node>;
+
+	NodeMap m_nodes;
+};
+
+} // namespace NoteVault
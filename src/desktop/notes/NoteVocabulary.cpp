@@ -0,0 +1,204 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NoteVocabulary.h"
+#include "NoteSet.h"
+#include <algorithm>
+
+namespace NoteVault
+{
+
+NoteVocabulary::NoteVocabulary()
+	: m_replacedId(NoteChange::cNoId)
+{
+}
+
+NoteVocabulary::~NoteVocabulary()
+{
+}
+
+void NoteVocabulary::build(const NoteSet& notes)
+{
+	clear();
+	for (const Note& note : notes)
+		updateNote(note);
+}
+
+void NoteVocabulary::clear()
+{
+	m_vocabulary.clear();
+	std::unordered_map<uint64_t, WordCounts>().swap(m_noteWords);
+	m_replacedId = NoteChange::cNoId;
+}
+
+void NoteVocabulary::replaceMessage(const Note& note, size_t offset, size_t length,
+	const char* data, size_t dataLength)
+{
+	std::unordered_map<uint64_t, WordCounts>::iterator foundIter =
+		m_noteWords.find(note.getId());
+	if (foundIter == m_noteWords.end())
+		return;
+
+	//Expand the range to the words touching it. Runs of word characters are only followed up to
+	//just past the maximum word length, since longer runs are skipped either way.
+	const NoteBody& message = note.getMessage();
+	size_t start = offset;
+	size_t minStart = offset > Vocabulary::cMaxWordLength ?
+		offset - Vocabulary::cMaxWordLength - 1 : 0;
+	while (start > minStart && Vocabulary::isWordChar(message.at(start - 1)))
+		--start;
+
+	size_t end = offset + length;
+	size_t maxEnd = std::min(message.size(), end + Vocabulary::cMaxWordLength + 1);
+	while (end < maxEnd && Vocabulary::isWordChar(message.at(end)))
+		++end;
+
+	std::string before = message.substr(start, offset - start);
+	std::string after = message.substr(offset + length, end - offset - length);
+	std::string replaced = message.substr(offset, length);
+
+	//The replaced words must all be known for the note, otherwise the note is scanned in full
+	//once the edit is made.
+	WordCounts removedWords;
+	bool found = true;
+	auto findWord = [this, &removedWords, &found](const char* word, size_t wordLength)
+	{
+		uint32_t node = m_vocabulary.find(word, wordLength);
+		if (node == Vocabulary::cNoNode)
+			found = false;
+		else
+			++removedWords[node];
+	};
+
+	Vocabulary::WordScanner scanner;
+	scanner.scan(before.data(), before.size(), findWord);
+	scanner.scan(replaced.data(), replaced.size(), findWord);
+	scanner.scan(after.data(), after.size(), findWord);
+	scanner.finish(findWord);
+	if (!found)
+		return;
+
+	WordCounts& noteWords = foundIter->second;
+	for (const WordCounts::value_type& removedWord : removedWords)
+	{
+		WordCounts::const_iterator noteWordIter = noteWords.find(removedWord.first);
+		if (noteWordIter == noteWords.end() || noteWordIter->second < removedWord.second)
+			return;
+	}
+
+	//Add the new words before removing the old ones so words in both keep the same node.
+	auto addWord = [this, &noteWords](const char* word, size_t wordLength)
+	{
+		++noteWords[m_vocabulary.add(word, wordLength)];
+	};
+
+	scanner.scan(before.data(), before.size(), addWord);
+	scanner.scan(data, dataLength, addWord);
+	scanner.scan(after.data(), after.size(), addWord);
+	scanner.finish(addWord);
+
+	for (const WordCounts::value_type& removedWord : removedWords)
+	{
+		WordCounts::iterator noteWordIter = noteWords.find(removedWord.first);
+		noteWordIter->second -= removedWord.second;
+		if (noteWordIter->second == 0)
+			noteWords.erase(noteWordIter);
+	}
+	removeWords(removedWords);
+
+	m_replacedId = note.getId();
+}
+
+void NoteVocabulary::notesChanged(NoteSet& notes, const std::vector<NoteChange>& changes)
+{
+	for (const NoteChange& change : changes)
+	{
+		if (change.type == NoteChange::Type::MessageChanged && change.id == m_replacedId)
+		{
+			m_replacedId = NoteChange::cNoId;
+			continue;
+		}
+
+		switch (change.type)
+		{
+			case NoteChange::Type::Inserted:
+			case NoteChange::Type::TitleChanged:
+			case NoteChange::Type::MessageChanged:
+			{
+				//The note may have been erased later in the same batch.
+				const Note* note = notes.find_note(change.id);
+				if (note)
+					updateNote(*note);
+				break;
+			}
+			case NoteChange::Type::Removed:
+				removeNote(change.id);
+				break;
+			case NoteChange::Type::Reset:
+				build(notes);
+				break;
+			default:
+				break;
+		}
+	}
+
+	m_replacedId = NoteChange::cNoId;
+}
+
+void NoteVocabulary::updateNote(const Note& note)
+{
+	WordCounts words;
+	auto addWord = [this, &words](const char* word, size_t length)
+	{
+		++words[m_vocabulary.add(word, length)];
+	};
+
+	Vocabulary::WordScanner scanner;
+	const NoteString& title = note.getTitle();
+	scanner.scan(title.data(), title.size(), addWord);
+	scanner.finish(addWord);
+
+	const NoteBody& message = note.getMessage();
+	for (size_t i = 0; i < message.getPieceCount(); ++i)
+	{
+		const NoteBody::Piece& piece = message.getPiece(i);
+		scanner.scan(piece.data, piece.size, addWord);
+	}
+	scanner.finish(addWord);
+
+	//The new words were added before removing the old ones so words in both keep the same node.
+	WordCounts& noteWords = m_noteWords[note.getId()];
+	removeWords(noteWords);
+	noteWords.swap(words);
+}
+
+void NoteVocabulary::removeNote(uint64_t id)
+{
+	std::unordered_map<uint64_t, WordCounts>::iterator foundIter = m_noteWords.find(id);
+	if (foundIter == m_noteWords.end())
+		return;
+
+	removeWords(foundIter->second);
+	m_noteWords.erase(foundIter);
+}
+
+void NoteVocabulary::removeWords(const WordCounts& words)
+{
+	for (const WordCounts::value_type& word : words)
+		m_vocabulary.remove(word.first, word.second);
+}
+
+} // namespace NoteVault
@@ -0,0 +1,66 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NoteSetListener.h"
+#include "Vocabulary.h"
+#include <unordered_map>
+
+namespace NoteVault
+{
+
+class Note;
+
+//Vocabulary of the words in the titles and messages of every note, kept up to date as notes
+//change. The words of each note are remembered so a changed note only updates the counts of the
+//words that differ, and edits within a message can be applied by only scanning the words around
+//them. The vocabulary is only kept in memory and is never saved.
+class NoteVocabulary : public NoteSetListener
+{
+public:
+	NoteVocabulary();
+	~NoteVocabulary();
+
+	const Vocabulary& getVocabulary() const	{return m_vocabulary;}
+
+	void build(const NoteSet& notes);
+	void clear();
+
+	//Updates the words for an edit to a note's message, called before the edit is made. The
+	//MessageChanged notification for the edit is then skipped rather than scanning the whole
+	//message again.
+	void replaceMessage(const Note& note, size_t offset, size_t length, const char* data,
+		size_t dataLength);
+
+	void notesChanged(NoteSet& notes, const std::vector<NoteChange>& changes) override;
+
+private:
+	//Number of times each word is used in a note, by the word's node in the vocabulary.
+	using WordCounts = std::unordered_map<uint32_t, uint32_t>;
+
+	NoteVocabulary(const NoteVocabulary&) = delete;
+	NoteVocabulary& operator=(const NoteVocabulary&) = delete;
+
+	void updateNote(const Note& note);
+	void removeNote(uint64_t id);
+	void removeWords(const WordCounts& words);
+
+	Vocabulary m_vocabulary;
+	std::unordered_map<uint64_t, WordCounts> m_noteWords;
+	uint64_t m_replacedId;
+};
+
+} // namespace NoteVault
@@ -0,0 +1,72 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <utility>
+#include <cstddef>
+#include <cassert>
+
+namespace NoteVault
+{
+
+//Fixed-capacity block of text that is only ever appended to. Bytes that have been handed out are
+//never modified or moved, so they may be shared between notes and read from other threads. The
+//text is cleansed once the last reference to the block is released.
+class TextBlock
+{
+public:
+	explicit TextBlock(size_t capacity)
+		: m_data(capacity, 0), m_size(0) {}
+	//Adopts the string as a full block.
+	explicit TextBlock(std::string contents)
+		: m_data(std::move(contents)), m_size(m_data.size()) {}
+	~TextBlock()	{cleanse(&m_data[0], m_data.size());}
+
+	//Zeroes memory in a way that won't be optimized away, even if it's about to be freed.
+	static void cleanse(void* data, size_t size);
+
+	const char* data() const	{return m_data.data();}
+	size_t getCapacity() const	{return m_data.size();}
+	size_t getSize() const	{return m_size;}
+	size_t getAvailable() const	{return m_data.size() - m_size;}
+
+	char* append(size_t size);
+
+private:
+	TextBlock(const TextBlock&) = delete;
+	TextBlock& operator=(const TextBlock&) = delete;
+
+	std::string m_data;
+	size_t m_size;
+};
+
+inline void TextBlock::cleanse(void* data, size_t size)
+{
+	volatile char* bytes = static_cast<volatile char*>(data);
+	for (size_t i = 0; i < size; ++i)
+		bytes[i] = 0;
+}
+
+inline char* TextBlock::append(size_t size)
+{
+	assert(size <= getAvailable());
+	char* data = &m_data[0] + m_size;
+	m_size += size;
+	return data;
+}
+
+} // namespace NoteVault
@@ -0,0 +1,388 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Vocabulary.h"
+#include "TextBlock.h"
+#include <algorithm>
+#include <cassert>
+#include <queue>
+
+namespace NoteVault
+{
+
+const uint32_t Vocabulary::cNoNode;
+const size_t Vocabulary::cMinWordLength;
+const size_t Vocabulary::cMaxWordLength;
+const uint32_t Vocabulary::cRootNode;
+
+//Entry when searching for completions. Nodes are either visited as words, ordered by their own
+//count, or as branches, ordered by the largest count below them.
+struct Vocabulary::Candidate
+{
+	uint32_t priority;
+	bool word;
+	uint32_t node;
+
+	bool operator<(const Candidate& other) const
+	{
+		//Words come before branches with the same count, so shorter words come first.
+		if (priority != other.priority)
+			return priority < other.priority;
+		if (word != other.word)
+			return !word;
+		return node > other.node;
+	}
+};
+
+bool Vocabulary::isWordChar(char c)
+{
+	if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))
+		return true;
+
+	switch (c)
+	{
+		case '_':
+		case '-':
+		case '.':
+		case '/':
+		case '@':
+		case '~':
+			return true;
+		default:
+			//Any byte of a multi-byte UTF-8 character.
+			return static_cast<unsigned char>(c) >= 0x80;
+	}
+}
+
+static void cleanseLabel(std::string& label)
+{
+	//Labels are edited in place, so the full capacity may hold parts of old words. Resizing first
+	//makes all of it part of the string so it may be written to.
+	label.resize(label.capacity());
+	TextBlock::cleanse(&label[0], label.size());
+	label.clear();
+}
+
+Vocabulary::Vocabulary()
+	: m_wordCount(0)
+{
+	clear();
+}
+
+Vocabulary::~Vocabulary()
+{
+	for (Node& node : m_nodes)
+		cleanseLabel(node.label);
+}
+
+uint32_t Vocabulary::add(const char* word, size_t length, uint32_t count)
+{
+	if (length == 0)
+		return cNoNode;
+
+	uint32_t node = cRootNode;
+	size_t offset = 0;
+	while (offset < length)
+	{
+		size_t childIndex;
+		uint32_t child = findChild(node, word[offset], childIndex);
+		if (child == cNoNode)
+		{
+			child = newNode(node, std::string(word + offset, length - offset));
+			std::vector<uint32_t>& children = m_nodes[node].children;
+			children.insert(children.begin() + childIndex, child);
+			node = child;
+			break;
+		}
+
+		const std::string& label = m_nodes[child].label;
+		size_t maxMatched = std::min(label.size(), length - offset);
+		size_t matched = 1;
+		while (matched < maxMatched && label[matched] == word[offset + matched])
+			++matched;
+
+		if (matched < label.size())
+		{
+			//Split the label with a new node for the shared part. The existing node keeps its
+			//index so the index for its word doesn't change.
+			uint32_t middle = newNode(node, label.substr(0, matched));
+			Node& childNode = m_nodes[child];
+			childNode.label.erase(0, matched);
+			childNode.parent = middle;
+
+			Node& middleNode = m_nodes[middle];
+			middleNode.maxCount = childNode.maxCount;
+			middleNode.children.push_back(child);
+			m_nodes[node].children[childIndex] = middle;
+			child = middle;
+		}
+
+		node = child;
+		offset += matched;
+	}
+
+	Node& wordNode = m_nodes[node];
+	if (wordNode.count == 0)
+		++m_wordCount;
+	if (count > UINT32_MAX - wordNode.count)
+		wordNode.count = UINT32_MAX;
+	else
+		wordNode.count += count;
+
+	for (uint32_t parent = node; parent != cNoNode && m_nodes[parent].maxCount < wordNode.count;
+		parent = m_nodes[parent].parent)
+	{
+		m_nodes[parent].maxCount = wordNode.count;
+	}
+	return node;
+}
+
+void Vocabulary::remove(uint32_t node, uint32_t count)
+{
+	assert(node < m_nodes.size() && m_nodes[node].count > 0);
+	Node& wordNode = m_nodes[node];
+	if (count < wordNode.count)
+	{
+		wordNode.count -= count;
+		updateMaxCount(node);
+		return;
+	}
+
+	wordNode.count = 0;
+	--m_wordCount;
+
+	//Remove nodes that are no longer needed: leaves without a word, and nodes without a word
+	//that only have a single child, which is merged with them.
+	while (node != cRootNode)
+	{
+		Node& curNode = m_nodes[node];
+		if (curNode.count > 0 || curNode.children.size() > 1)
+			break;
+
+		uint32_t parent = curNode.parent;
+		if (curNode.children.empty())
+		{
+			std::vector<uint32_t>& children = m_nodes[parent].children;
+			children.erase(std::find(children.begin(), children.end(), node));
+			freeNode(node);
+			node = parent;
+		}
+		else
+		{
+			uint32_t child = curNode.children.front();
+			Node& childNode = m_nodes[child];
+			std::string label = curNode.label + childNode.label;
+			cleanseLabel(childNode.label);
+			childNode.label = std::move(label);
+			childNode.parent = parent;
+			replaceChild(parent, node, child);
+			freeNode(node);
+			node = parent;
+			break;
+		}
+	}
+
+	updateMaxCount(node);
+}
+
+uint32_t Vocabulary::find(const char* word, size_t length) const
+{
+	uint32_t node = cRootNode;
+	size_t offset = 0;
+	while (offset < length)
+	{
+		size_t childIndex;
+		node = findChild(node, word[offset], childIndex);
+		if (node == cNoNode)
+			return cNoNode;
+
+		const std::string& label = m_nodes[node].label;
+		if (label.size() > length - offset || label.compare(0, label.size(), word + offset,
+			label.size()) != 0)
+		{
+			return cNoNode;
+		}
+		offset += label.size();
+	}
+
+	if (node == cRootNode || m_nodes[node].count == 0)
+		return cNoNode;
+	return node;
+}
+
+void Vocabulary::complete(std::vector<std::string>& words, const char* prefix, size_t length,
+	size_t maxWords) const
+{
+	//Find the branch holding all of the words with the prefix, which may end partway through
+	//its label.
+	uint32_t node = cRootNode;
+	size_t offset = 0;
+	while (offset < length)
+	{
+		size_t childIndex;
+		node = findChild(node, prefix[offset], childIndex);
+		if (node == cNoNode)
+			return;
+
+		const std::string& label = m_nodes[node].label;
+		size_t compareLength = std::min(label.size(), length - offset);
+		if (label.compare(0, compareLength, prefix + offset, compareLength) != 0)
+			return;
+		offset += compareLength;
+	}
+
+	std::priority_queue<Candidate> candidates;
+	candidates.push(Candidate{m_nodes[node].maxCount, false, node});
+	while (!candidates.empty() && maxWords > 0)
+	{
+		Candidate candidate = candidates.top();
+		candidates.pop();
+		if (candidate.priority == 0)
+			break;
+
+		if (candidate.word)
+		{
+			words.emplace_back();
+			getWord(words.back(), candidate.node);
+			--maxWords;
+			continue;
+		}
+
+		const Node& branch = m_nodes[candidate.node];
+		if (branch.count > 0)
+			candidates.push(Candidate{branch.count, true, candidate.node});
+		for (uint32_t child : branch.children)
+			candidates.push(Candidate{m_nodes[child].maxCount, false, child});
+	}
+}
+
+void Vocabulary::clear()
+{
+	for (Node& node : m_nodes)
+		cleanseLabel(node.label);
+	std::vector<Node>().swap(m_nodes);
+	std::vector<uint32_t>().swap(m_freeNodes);
+	m_wordCount = 0;
+
+	Node root;
+	root.parent = cNoNode;
+	root.count = 0;
+	root.maxCount = 0;
+	m_nodes.push_back(std::move(root));
+}
+
+uint32_t Vocabulary::newNode(uint32_t parent, std::string label)
+{
+	uint32_t node;
+	if (m_freeNodes.empty())
+	{
+		//Grow manually so the short labels stored in the old nodes can be cleansed after they're
+		//moved.
+		if (m_nodes.size() == m_nodes.capacity())
+		{
+			std::vector<Node> nodes;
+			nodes.reserve(m_nodes.size()*2);
+			for (Node& oldNode : m_nodes)
+			{
+				nodes.push_back(std::move(oldNode));
+				cleanseLabel(oldNode.label);
+			}
+			m_nodes.swap(nodes);
+		}
+
+		node = static_cast<uint32_t>(m_nodes.size());
+		m_nodes.emplace_back();
+	}
+	else
+	{
+		node = m_freeNodes.back();
+		m_freeNodes.pop_back();
+	}
+
+	Node& newNode = m_nodes[node];
+	newNode.label = std::move(label);
+	newNode.parent = parent;
+	newNode.count = 0;
+	newNode.maxCount = 0;
+	newNode.children.clear();
+	return node;
+}
+
+void Vocabulary::freeNode(uint32_t node)
+{
+	Node& freedNode = m_nodes[node];
+	cleanseLabel(freedNode.label);
+	std::string().swap(freedNode.label);
+	std::vector<uint32_t>().swap(freedNode.children);
+	freedNode.parent = cNoNode;
+	freedNode.count = 0;
+	freedNode.maxCount = 0;
+	m_freeNodes.push_back(node);
+}
+
+uint32_t Vocabulary::findChild(uint32_t node, char c, size_t& childIndex) const
+{
+	const std::vector<uint32_t>& children = m_nodes[node].children;
+	std::vector<uint32_t>::const_iterator foundIter = std::lower_bound(children.begin(),
+		children.end(), static_cast<unsigned char>(c),
+		[this] (uint32_t child, unsigned char c) -> bool
+		{
+			return static_cast<unsigned char>(m_nodes[child].label[0]) < c;
+		});
+
+	childIndex = foundIter - children.begin();
+	if (foundIter == children.end() || m_nodes[*foundIter].label[0] != c)
+		return cNoNode;
+	return *foundIter;
+}
+
+void Vocabulary::replaceChild(uint32_t node, uint32_t child, uint32_t newChild)
+{
+	std::vector<uint32_t>& children = m_nodes[node].children;
+	*std::find(children.begin(), children.end(), child) = newChild;
+}
+
+void Vocabulary::updateMaxCount(uint32_t node)
+{
+	for (; node != cNoNode; node = m_nodes[node].parent)
+	{
+		Node& curNode = m_nodes[node];
+		uint32_t maxCount = curNode.count;
+		for (uint32_t child : curNode.children)
+			maxCount = std::max(maxCount, m_nodes[child].maxCount);
+
+		if (maxCount == curNode.maxCount)
+			break;
+		curNode.maxCount = maxCount;
+	}
+}
+
+void Vocabulary::getWord(std::string& word, uint32_t node) const
+{
+	size_t length = 0;
+	for (uint32_t parent = node; parent != cNoNode; parent = m_nodes[parent].parent)
+		length += m_nodes[parent].label.size();
+
+	word.resize(length);
+	for (; node != cNoNode; node = m_nodes[node].parent)
+	{
+		const std::string& label = m_nodes[node].label;
+		length -= label.size();
+		std::copy(label.begin(), label.end(), word.begin() + length);
+	}
+}
+
+} // namespace NoteVault
@@ -0,0 +1,148 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace NoteVault
+{
+
+//Words typed across notes along with how often each is used, kept in a radix trie to complete
+//words from a prefix. Each node also holds the largest count below it, so the most used
+//completions are found by only visiting the branches that can hold them rather than every word
+//with the prefix. Nodes are kept in a single array and referenced by index, and the index of a
+//word's node stays the same for as long as the word is used.
+class Vocabulary
+{
+public:
+	static const uint32_t cNoNode = static_cast<uint32_t>(-1);
+
+	//Length limits for words, in bytes. Longer runs are usually encoded data, such as keys.
+	static const size_t cMinWordLength = 3;
+	static const size_t cMaxWordLength = 128;
+
+	//Splits text into words, which may be given in pieces. Words are runs of letters, digits,
+	//non-ASCII characters, and the punctuation found in host names, user names, and paths. Runs
+	//longer than the maximum word length are skipped.
+	class WordScanner
+	{
+	public:
+		WordScanner()
+			: m_skip(false)
+		{
+		}
+
+		//The function is called with the data and length of each word.
+		template <typename F>
+		void scan(const char* data, size_t size, F&& function);
+
+		//Ends the last word, which must be called after the last piece of text.
+		template <typename F>
+		void finish(F&& function);
+
+	private:
+		std::string m_word;
+		bool m_skip;
+	};
+
+	static bool isWordChar(char c);
+
+	Vocabulary();
+	~Vocabulary();
+
+	//Adds uses of a word, returning its node.
+	uint32_t add(const char* word, size_t length, uint32_t count = 1);
+
+	//Removes uses of the word for a node returned from add(). Once all uses are removed the node
+	//may be reused for another word.
+	void remove(uint32_t node, uint32_t count = 1);
+
+	uint32_t find(const char* word, size_t length) const;
+	uint32_t getCount(uint32_t node) const	{return m_nodes[node].count;}
+
+	//Finds the most used words starting with the prefix, including the prefix itself if it's a
+	//word, from most to least used.
+	void complete(std::vector<std::string>& words, const char* prefix, size_t length,
+		size_t maxWords) const;
+
+	size_t getWordCount() const	{return m_wordCount;}
+
+	//Removes all words, cleansing them before they're released.
+	void clear();
+
+private:
+	static const uint32_t cRootNode = 0;
+
+	struct Candidate;
+
+	struct Node
+	{
+		std::string label;
+		uint32_t parent;
+		uint32_t count;
+		uint32_t maxCount;
+
+		//Sorted by the first character of their labels.
+		std::vector<uint32_t> children;
+	};
+
+	uint32_t newNode(uint32_t parent, std::string label);
+	void freeNode(uint32_t node);
+	uint32_t findChild(uint32_t node, char c, size_t& childIndex) const;
+	void replaceChild(uint32_t node, uint32_t child, uint32_t newChild);
+	void updateMaxCount(uint32_t node);
+	void getWord(std::string& word, uint32_t node) const;
+
+	std::vector<Node> m_nodes;
+	std::vector<uint32_t> m_freeNodes;
+	size_t m_wordCount;
+};
+
+template <typename F>
+void Vocabulary::WordScanner::scan(const char* data, size_t size, F&& function)
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		if (!isWordChar(data[i]))
+			finish(function);
+		else if (m_word.size() < cMaxWordLength)
+			m_word.push_back(data[i]);
+		else
+			m_skip = true;
+	}
+}
+
+template <typename F>
+void Vocabulary::WordScanner::finish(F&& function)
+{
+	if (!m_skip)
+	{
+		//Words may be at the end of a sentence.
+		size_t length = m_word.size();
+		while (length > 0 && m_word[length - 1] == '.')
+			--length;
+		if (length >= cMinWordLength)
+			function(m_word.data(), length);
+	}
+
+	m_word.clear();
+	m_skip = false;
+}
+
+} // namespace NoteVault
@@ -0,0 +1,213 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AutoSaver.h"
+
+#include "SaveFileOStream.h"
+#include "io/Crypto.h"
+#include "io/NoteFile.h"
+#include "notes/NoteSet.h"
+
+#include "AutoSaver.moc"
+
+namespace NoteVault
+{
+
+const int AutoSaver::cDefaultDebounceTimeMs;
+const int AutoSaver::cDefaultMaxLatencyMs;
+
+struct AutoSaver::SaveTask
+{
+	~SaveTask()
+	{
+		Crypto::cleanse(key);
+	}
+
+	NoteSnapshot notes;
+	std::string path;
+	std::vector<uint8_t> salt;
+	std::vector<uint8_t> key;
+	uint64_t generation;
+	uint64_t epoch;
+
+	bool hasPreviousHash;
+	uint64_t previousHash;
+
+	uint64_t hash;
+	NoteHash::NoteMap noteHashes;
+	bool success;
+};
+
+AutoSaver::AutoSaver(QObject* parent)
+	: QObject(parent), m_enabled(true), m_saving(false), m_pendingSave(false), m_generation(0),
+	m_epoch(0), m_hasSavedHash(false), m_savedHash(0)
+{
+	m_debounceTimer.setSingleShot(true);
+	m_debounceTimer.setInterval(cDefaultDebounceTimeMs);
+	connect(&m_debounceTimer, SIGNAL(timeout()), this, SLOT(onSaveTimeout()));
+
+	m_maxLatencyTimer.setSingleShot(true);
+	m_maxLatencyTimer.setInterval(cDefaultMaxLatencyMs);
+	connect(&m_maxLatencyTimer, SIGNAL(timeout()), this, SLOT(onSaveTimeout()));
+
+	// Saves write to the same file, so they must never overlap.
+	m_threadPool.setMaxThreadCount(1);
+}
+
+AutoSaver::~AutoSaver()
+{
+	m_threadPool.waitForDone();
+}
+
+void AutoSaver::notesReplaced()
+{
+	m_snapshotter.clear();
+}
+
+void AutoSaver::notesChanged(NoteSet& notes, const std::vector<NoteChange>& changes)
+{
+	m_snapshotter.notesChanged(notes, changes);
+}
+
+void AutoSaver::setEnabled(bool enabled)
+{
+	m_enabled = enabled;
+	if (!m_enabled)
+	{
+		m_debounceTimer.stop();
+		m_maxLatencyTimer.stop();
+		m_pendingSave = false;
+	}
+}
+
+void AutoSaver::setDebounceTime(int ms)
+{
+	m_debounceTimer.setInterval(ms);
+}
+
+void AutoSaver::setMaxLatency(int ms)
+{
+	m_maxLatencyTimer.setInterval(ms);
+}
+
+void AutoSaver::notesModified()
+{
+	++m_generation;
+	if (!m_enabled)
+		return;
+
+	m_debounceTimer.start();
+	if (!m_maxLatencyTimer.isActive())
+		m_maxLatencyTimer.start();
+}
+
+bool AutoSaver::save(const NoteSet& notes, const std::string& path,
+	const std::vector<uint8_t>& salt, const std::vector<uint8_t>& key)
+{
+	m_debounceTimer.stop();
+	m_maxLatencyTimer.stop();
+	if (m_saving)
+	{
+		m_pendingSave = true;
+		return false;
+	}
+
+	// Only the notes changed since the last snapshot are copied, and copies only reference the
+	// text, so this is cheap enough to do while the user is typing. The worker only reads the
+	// snapshot.
+	std::shared_ptr<SaveTask> task = std::make_shared<SaveTask>();
+	task->notes = m_snapshotter.take(notes);
+	task->path = path;
+	task->salt = salt;
+	task->key = key;
+	task->generation = m_generation;
+	task->epoch = m_epoch;
+	task->hasPreviousHash = m_hasSavedHash;
+	task->previousHash = m_savedHash;
+	task->hash = 0;
+	task->success = false;
+
+	m_saving = true;
+	m_threadPool.start([this, task]()
+		{
+			task->hash = NoteHash::hash(task->notes, task->noteHashes);
+			if (task->hasPreviousHash && task->hash == task->previousHash)
+				task->success = true;
+			else
+			{
+				SaveFileOStream stream;
+				task->success = stream.open(task->path) && NoteFile::saveNotes(task->notes,
+					stream, task->salt, task->key) == NoteFile::Result::Success &&
+					stream.commit();
+			}
+
+			// Release the plaintext and key before waiting on the UI thread, so they're gone
+			// once waitForSave() returns.
+			task->notes = NoteSnapshot();
+			Crypto::cleanse(task->key);
+
+			QMetaObject::invokeMethod(this, [this, task]() {finishSave(*task);},
+				Qt::QueuedConnection);
+		});
+	return true;
+}
+
+void AutoSaver::reset()
+{
+	++m_generation;
+	++m_epoch;
+	m_debounceTimer.stop();
+	m_maxLatencyTimer.stop();
+	m_pendingSave = false;
+	m_hasSavedHash = false;
+	m_savedNoteHashes.clear();
+}
+
+void AutoSaver::waitForSave()
+{
+	m_threadPool.waitForDone();
+}
+
+void AutoSaver::onSaveTimeout()
+{
+	if (m_enabled)
+		Q_EMIT saveRequested();
+}
+
+void AutoSaver::finishSave(SaveTask& task)
+{
+	m_saving = false;
+	if (task.epoch == m_epoch)
+	{
+		if (task.success)
+		{
+			m_hasSavedHash = true;
+			m_savedHash = task.hash;
+			m_savedNoteHashes = std::move(task.noteHashes);
+			Q_EMIT saved(task.generation == m_generation);
+		}
+		else
+			Q_EMIT saveFailed();
+	}
+
+	if (m_pendingSave)
+	{
+		m_pendingSave = false;
+		Q_EMIT saveRequested();
+	}
+}
+
+} // namespace NoteVault
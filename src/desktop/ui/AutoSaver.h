@@ -0,0 +1,121 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "notes/NoteHash.h"
+#include "notes/NoteSnapshot.h"
+#include <QtCore/QObject>
+#include <QtCore/QThreadPool>
+#include <QtCore/QTimer>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace NoteVault
+{
+
+class NoteSet;
+
+// Saves notes in the background after they're modified. Edits are coalesced until no changes have
+// been made for the debounce time, but a save is never put off for longer than the max latency
+// after the first unsaved change. Saving works from a snapshot of the notes on a worker thread,
+// and the write is skipped if the contents hash the same as the last autosave. Changes to the
+// notes must be passed to notesChanged() so each snapshot only copies the notes that changed.
+// The file is written to a temporary file that replaces it once complete.
+class AutoSaver : public QObject, public NoteSetListener
+{
+	Q_OBJECT
+public:
+	static const int cDefaultDebounceTimeMs = 2000;
+	static const int cDefaultMaxLatencyMs = 30000;
+
+	explicit AutoSaver(QObject* parent = nullptr);
+	~AutoSaver();
+
+	bool isEnabled() const	{return m_enabled;}
+	void setEnabled(bool enabled);
+
+	int getDebounceTime() const	{return m_debounceTimer.interval();}
+	void setDebounceTime(int ms);
+
+	int getMaxLatency() const	{return m_maxLatencyTimer.interval();}
+	void setMaxLatency(int ms);
+
+	bool isSaving() const	{return m_saving;}
+
+	// Call whenever the notes are modified.
+	void notesModified();
+
+	// Call when the notes are replaced without reporting the changes, such as when opening or
+	// locking a file.
+	void notesReplaced();
+
+	void notesChanged(NoteSet& notes, const std::vector<NoteChange>& changes) override;
+
+	// Starts saving a snapshot of the notes, returning false if a save is already in progress.
+	// In that case saveRequested() is emitted again once it finishes.
+	bool save(const NoteSet& notes, const std::string& path, const std::vector<uint8_t>& salt,
+		const std::vector<uint8_t>& key);
+
+	// Cancels any pending autosave, such as after saving explicitly or switching files. A save
+	// that's already in progress will finish, but won't be reported as up to date.
+	void reset();
+
+	// Blocks until the save in progress, if any, has been written and has released its copy of the
+	// notes and key.
+	void waitForSave();
+
+	// Hashes of each note as of the last successful save.
+	const NoteHash::NoteMap& getSavedNoteHashes() const	{return m_savedNoteHashes;}
+
+Q_SIGNALS:
+	// The notes should be passed to save().
+	void saveRequested();
+
+	// upToDate is true if no changes were made since the snapshot was taken.
+	void saved(bool upToDate);
+	void saveFailed();
+
+private Q_SLOTS:
+	void onSaveTimeout();
+
+private:
+	struct SaveTask;
+
+	void finishSave(SaveTask& task);
+
+	QTimer m_debounceTimer;
+	QTimer m_maxLatencyTimer;
+	bool m_enabled;
+	bool m_saving;
+	bool m_pendingSave;
+
+	// The generation changes with every modification and the epoch with every reset, so results
+	// from older snapshots can be recognized.
+	uint64_t m_generation;
+	uint64_t m_epoch;
+
+	bool m_hasSavedHash;
+	uint64_t m_savedHash;
+	NoteHash::NoteMap m_savedNoteHashes;
+	NoteSnapshotter m_snapshotter;
+
+	// Declared last so it's destroyed first, waiting for the save in progress.
+	QThreadPool m_threadPool;
+};
+
+} // namespace NoteVault
@@ -17,23 +17,53 @@
 #include "MainWindow.h"
 
 #include "AboutDialog.h"
+#include "AutoSaver.h"
 #include "ConfirmCloseDialog.h"
 #include "OpenPasswordDialog.h"
+#include "SaveFileOStream.h"
 #include "SavePasswordDialog.h"
 #include "GeneratePasswordDialog.h"
+#include "MarkdownPreview.h"
+#include "NoteCompleter.h"
+#include "NoteDocumentCache.h"
+#include "NoteHighlighter.h"
+#include "NoteTreeModel.h"
+#include "NoteStrings.h"
 #include "io/Crypto.h"
 #include "io/FileIStream.h"
-#include "io/FileOStream.h"
+#include "io/MemoryIStream.h"
+#include "io/MemoryOStream.h"
 #include "io/NoteFile.h"
+#include "notes/NoteHash.h"
+#include "notes/NoteMerge.h"
 #include "notes/NoteSet.h"
+#include "notes/NoteTree.h"
+#include "notes/NoteVocabulary.h"
+#include "StartupTrace.h"
+#include <QtCore/QDateTime>
 #include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QFileSystemWatcher>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QItemSelectionModel>
+#include <QtCore/QPromise>
+#include <QtCore/QThreadPool>
 #include <QtCore/QTimer>
+#include <QtCore/QUrl>
+#include <QtGui/QDesktopServices>
 #include <QtGui/QKeyEvent>
+#include <QtGui/QTextCursor>
+#include <QtGui/QTextDocument>
 #include <QtGui/QUndoStack>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QFileDialog>
 #include <QtWidgets/QLineEdit>
 #include <QtWidgets/QMessageBox>
+#include <QtWidgets/QProgressBar>
+#include <QtWidgets/QStatusBar>
+#include <algorithm>
+#include <climits>
+#include <unordered_set>
 #include <assert.h>
 
 #include "ui_MainWindow.h"
@@ -46,29 +76,242 @@
 namespace NoteVault
 {
 
+// Time without edits before compacting the note storage.
+static const int cCompactIdleTimeMs = 30000;
+
+// Default limit for the text held by the note undo history.
+static const size_t cDefaultUndoMemoryBudget = 32*1024*1024;
+
+// Notes larger than this are loaded into the editor over multiple event loop iterations.
+static const size_t cLargeNoteSize = 1024*1024;
+static const size_t cLoadChunkSize = 256*1024;
+
+// Default time without input before locking the notes.
+static const int cDefaultLockIdleTimeMs = 10*60*1000;
+
+// Size of each read when reading a whole file into memory.
+static const size_t cFileReadSize = 1024*1024;
+
+// Notes are shown in batches while a file is opened. The first batch is small so the list fills in
+// quickly, and later batches grow so merging them into the sorted list stays cheap.
+static const size_t cFirstOpenBatchSize = 256;
+static const size_t cMaxOpenBatchSize = 16*1024;
+
+// Time to wait for changes to the file on disk to settle before reloading it.
+static const int cFileCheckDelayMs = 500;
+
+// How long to show that an autosave failed.
+static const int cAutoSaveMessageTimeMs = 10000;
+
+static bool compareTitles(const Note& left, const Note& right)
+{
+	return strcasecmp(left.getTitle().c_str(), right.getTitle().c_str()) < 0;
+}
+
+// Converts text from a QTextCursor selection the same way QTextDocument::toPlainText() does.
+static QString toPlainText(QString text)
+{
+	for (QChar& c : text)
+	{
+		switch (c.unicode())
+		{
+			case 0xfdd0:
+			case 0xfdd1:
+			case QChar::ParagraphSeparator:
+			case QChar::LineSeparator:
+				c = QLatin1Char('\n');
+				break;
+			case QChar::Nbsp:
+				c = QLatin1Char(' ');
+				break;
+			default:
+				break;
+		}
+	}
+	return text;
+}
+
+// Contents of a file read into memory ahead of time, with the unencrypted header already parsed.
+// The size and modified time are from before reading, so a file changed since then is detected.
+struct FileImage
+{
+	std::vector<uint8_t> data;
+	NoteFile::Header header;
+	size_t headerSize;
+	NoteFile::Result result;
+	qint64 fileSize;
+	QDateTime fileModified;
+};
+
+using FileImageFuture = QFuture<std::shared_ptr<const FileImage>>;
+
+// Notes decrypted while opening a file, sorted by title.
+using NoteBatch = std::shared_ptr<std::vector<Note>>;
+
+static int toProgress(size_t count)
+{
+	return static_cast<int>(std::min<size_t>(count, INT_MAX));
+}
+
+static std::shared_ptr<const FileImage> readFileImage(const std::string& filePath)
+{
+	std::shared_ptr<FileImage> image = std::make_shared<FileImage>();
+	image->headerSize = 0;
+
+	QFileInfo fileInfo(QString::fromStdString(filePath));
+	image->fileSize = fileInfo.size();
+	image->fileModified = fileInfo.lastModified();
+
+	FileIStream stream;
+	if (!stream.open(filePath))
+	{
+		image->result = NoteFile::Result::IoError;
+		return image;
+	}
+
+	size_t readSize;
+	do
+	{
+		size_t offset = image->data.size();
+		image->data.resize(offset + cFileReadSize);
+		readSize = stream.read(image->data.data() + offset, cFileReadSize);
+		image->data.resize(offset + readSize);
+	} while (readSize == cFileReadSize);
+	image->data.shrink_to_fit();
+
+	MemoryIStream headerStream(image->data.data(), image->data.size());
+	image->result = NoteFile::readHeader(image->header, headerStream);
+	image->headerSize = headerStream.getOffset();
+	return image;
+}
+
+static bool isFileImageCurrent(const FileImage& image, const std::string& filePath)
+{
+	QFileInfo fileInfo(QString::fromStdString(filePath));
+	return fileInfo.size() == image.fileSize && fileInfo.lastModified() == image.fileModified;
+}
+
+// File being opened on a worker thread. The notes are handed to the window in batches as the
+// results of the promise, which the window tracks with batchCount and populated.
+struct MainWindow::OpenTask
+{
+	QPromise<NoteBatch> promise;
+	std::string filePath;
+	std::string password;
+	NoteSet noteSet;
+	std::vector<uint8_t> salt;
+	std::vector<uint8_t> key;
+	NoteHash::NoteMap noteHashes;
+	NoteFile::Result result;
+
+	int batchCount;
+	bool populated;
+};
+
+// File loaded again on a worker thread after it was changed by another program. The key is reused,
+// so reloading fails with keyChanged set if the file was saved with a different password.
+struct MainWindow::ReloadTask
+{
+	QPromise<void> promise;
+	std::string filePath;
+	std::vector<uint8_t> salt;
+	std::vector<uint8_t> key;
+	qint64 fileSize;
+	QDateTime fileModified;
+	NoteSet noteSet;
+	NoteHash::NoteMap noteHashes;
+	NoteFile::Result result;
+	bool keyChanged;
+};
+
 struct MainWindow::ChildItems
 {
 	ChildItems(QWidget* parent)
-		: aboutDialog(parent), confirmCloseDialog(parent), openPasswordDialog(parent),
-		savePasswordDialog(parent), generatePasswordDialog(parent), fileDialog(parent)
+		: parent(parent), undoHistorySize(0), undoIndex(0), openProgress(nullptr),
+		  loadingNoteId(NoteChange::cNoId), loadOffset(0)
 	{
 	}
 
-	AboutDialog aboutDialog;
-	ConfirmCloseDialog confirmCloseDialog;
-	OpenPasswordDialog openPasswordDialog;
-	SavePasswordDialog savePasswordDialog;
-	GeneratePasswordDialog generatePasswordDialog;
-	QFileDialog fileDialog;
+	// Dialogs are created on first use to keep them out of startup.
+	AboutDialog& getAboutDialog()	{return getDialog(aboutDialog);}
+	ConfirmCloseDialog& getConfirmCloseDialog()	{return getDialog(confirmCloseDialog);}
+	OpenPasswordDialog& getOpenPasswordDialog()	{return getDialog(openPasswordDialog);}
+	SavePasswordDialog& getSavePasswordDialog()	{return getDialog(savePasswordDialog);}
+	GeneratePasswordDialog& getGeneratePasswordDialog()	{return getDialog(generatePasswordDialog);}
+	QFileDialog& getFileDialog();
+
+	template <typename T>
+	T& getDialog(std::unique_ptr<T>& dialog)
+	{
+		if (!dialog)
+			dialog.reset(new T(parent));
+		return *dialog;
+	}
+
+	QWidget* parent;
+	std::unique_ptr<AboutDialog> aboutDialog;
+	std::unique_ptr<ConfirmCloseDialog> confirmCloseDialog;
+	std::unique_ptr<OpenPasswordDialog> openPasswordDialog;
+	std::unique_ptr<SavePasswordDialog> savePasswordDialog;
+	std::unique_ptr<GeneratePasswordDialog> generatePasswordDialog;
+	std::unique_ptr<QFileDialog> fileDialog;
+
+	// Payload size of all commands in the undo stack, and the index it was last seen at. Declared
+	// before the stack since commands take their size out of the total as they're deleted.
+	size_t undoHistorySize;
+	int undoIndex;
 	QUndoStack undoStack;
-	QTimer timer;
+	NoteTreeModel noteTreeModel;
+	NoteDocumentCache documentCache;
+	MarkdownPreview markdownPreview;
+	NoteVocabulary noteVocabulary;
+	std::unique_ptr<NoteCompleter> noteCompleter;
+	AutoSaver autoSaver;
+	QTimer menuUpdateTimer;
+	QTimer compactTimer;
+	QTimer loadTimer;
+	QTimer lockTimer;
+	QFutureWatcher<NoteBatch> openWatcher;
+	QProgressBar* openProgress;
+	std::shared_ptr<OpenTask> openTask;
+	FileImageFuture readAhead;
+	std::string readAheadPath;
+	QFileSystemWatcher fileWatcher;
+	QTimer fileCheckTimer;
+	QFutureWatcher<void> reloadWatcher;
+	std::shared_ptr<ReloadTask> reloadTask;
+
+	uint64_t loadingNoteId;
+	size_t loadOffset;
 };
 
+QFileDialog& MainWindow::ChildItems::getFileDialog()
+{
+	if (fileDialog)
+		return *fileDialog;
+
+	QStringList filter;
+	filter.append("Secure note files (*.secnote)");
+
+	getDialog(fileDialog);
+	fileDialog->setNameFilters(filter);
+	fileDialog->setDefaultSuffix(".secnote");
+	fileDialog->setDirectory(QDir::home());
+	return *fileDialog;
+}
+
 struct MainWindow::NoteContext
 {
-	NoteContext()
-		: dirty(false)
+	explicit NoteContext(NoteSetListener& listener)
+		: dirty(false), locked(false), fileSize(0), reloading(false), populating(false),
+		selectedNoteId(NoteChange::cNoId)
+	{
+		noteSet.addListener(&listener);
+	}
+
+	~NoteContext()
 	{
+		Crypto::cleanse(key);
 	}
 
 	NoteSet noteSet;
@@ -79,74 +322,143 @@ struct MainWindow::NoteContext
 	bool dirty;
 	std::string fileName;
 
+	// While locked, the notes are only kept in the encrypted image and the key is wiped.
+	bool locked;
+	std::vector<uint8_t> lockedImage;
+
+	// Changes made to the file by other programs are merged against the hashes of the notes as
+	// last loaded or saved, along with the ids of notes changed since. Ids of notes changed before
+	// an autosave in progress are held separately until it finishes. The size and modification
+	// time tell apart our own writes; an invalid time means the file's state isn't known.
+	NoteHash::NoteMap fileNoteHashes;
+	std::unordered_set<uint64_t> modifiedIds;
+	std::unordered_set<uint64_t> autoSavingIds;
+	qint64 fileSize;
+	QDateTime fileModified;
+	bool reloading;
+
+	// Notes are still being added from a file that's being opened. They match the file and are
+	// already sorted, and can't be edited until the file is fully loaded.
+	bool populating;
+
+	// The iterator is refreshed from the id whenever notes are inserted, removed, or reordered.
 	NoteSet::iterator selectedNote;
+	uint64_t selectedNoteId;
 };
 
 
-class MainWindow::NoteCommand : public QUndoCommand
+class MainWindow::HistoryCommand : public QUndoCommand
 {
 public:
-	NoteCommand(const QString& text, MainWindow& parent, const Note& note)
-		: QUndoCommand(text), m_parent(&parent), m_note(note)
+	explicit HistoryCommand(const QString& text)
+		: QUndoCommand(text), m_trimmed(false), m_historySize(nullptr), m_countedSize(0)
+	{
+	}
+
+	~HistoryCommand()
+	{
+		if (m_historySize)
+			*m_historySize -= m_countedSize;
+	}
+
+	// Trimmed commands have released their data to stay within the undo memory budget, and can
+	// no longer be undone or redone.
+	bool isTrimmed() const	{return m_trimmed;}
+	void trim()
+	{
+		releasePayload();
+		m_trimmed = true;
+		if (m_historySize)
+			countSize(*m_historySize);
+	}
+
+	virtual size_t getPayloadSize() const = 0;
+
+	// Keeps the payload size included in the total for the whole history up to date. Called once
+	// the command is pushed and again after it's undone or redone, which may snapshot notes. The
+	// size is taken out of the total again when the command is deleted.
+	void countSize(size_t& historySize)
+	{
+		size_t size = getPayloadSize();
+		historySize = historySize - m_countedSize + size;
+		m_historySize = &historySize;
+		m_countedSize = size;
+	}
+
+protected:
+	virtual void releasePayload() = 0;
+
+private:
+	bool m_trimmed;
+	size_t* m_historySize;
+	size_t m_countedSize;
+};
+
+class MainWindow::NoteCommand : public HistoryCommand
+{
+public:
+	NoteCommand(const QString& text, MainWindow& parent, Note note)
+		: HistoryCommand(text), m_parent(&parent), m_note(std::move(note))
 	{
 	}
 
 	uint64_t getNoteId() const	{return m_note.getId();}
-	void updateNote(const Note& note) const
+
+	size_t getPayloadSize() const override
 	{
-		if (note.getId() != m_note.getId())
-			return;
-		m_note = note;
+		return m_note.getTitle().size() + m_note.getMessage().size();
 	}
 
 protected:
+	void releasePayload() override
+	{
+		m_note = Note(m_note.getId());
+	}
+
 	MainWindow* m_parent;
-	mutable Note m_note;
+	Note m_note;
 };
 
 class MainWindow::AddCommand : public NoteCommand
 {
 public:
-	AddCommand(MainWindow& parent, const Note& note)
-		: NoteCommand("add note", parent, note)
+	AddCommand(MainWindow& parent, Note note)
+		: NoteCommand("add note", parent, std::move(note))
 	{
 	}
 
 	void undo() override
 	{
+		if (isTrimmed())
+			return;
+
+		// Snapshot the note as it's removed so later commands don't need to track edits to it.
+		// Copying only shares the note's text storage.
+		// The note may have been removed since by merging changes made to the file on disk.
 		NoteSet& noteSet = m_parent->m_notes->noteSet;
 		NoteSet::iterator foundIter = noteSet.find(m_note.getId());
-		ptrdiff_t index = foundIter - m_parent->m_notes->noteSet.begin();
-		delete m_parent->m_impl->noteList->takeItem(static_cast<int>(index));
-		noteSet.erase(foundIter);
+		if (foundIter == noteSet.end())
+			return;
 
-		QList<QListWidgetItem*> selectedItems = m_parent->m_impl->noteList->selectedItems();
-		if (selectedItems.empty())
-			m_parent->updateForDeselection();
-		else
-		{
-			index = m_parent->m_impl->noteList->row(selectedItems[0]);
-			m_parent->updateForSelection(index);
-		}
-		m_parent->markDirty();
+		m_note = *foundIter;
+		noteSet.erase(foundIter);
 	}
 
 	void redo() override
 	{
+		if (isTrimmed())
+			return;
+
 		NoteSet& noteSet = m_parent->m_notes->noteSet;
 		noteSet.insert(noteSet.end(), m_note);
-		m_parent->sortNotes();
-		m_parent->updateUi();
 
-		ptrdiff_t index = noteSet.find(m_note.getId()) - noteSet.begin();
-		m_parent->m_impl->noteList->setCurrentRow(static_cast<int>(index));
-		m_parent->updateForSelection(index);
-		m_parent->markDirty();
+		m_parent->selectNote(m_note.getId());
+		m_parent->updateForSelection(m_note.getId());
 	}
 
 protected:
-	AddCommand(const QString& text, MainWindow& parent, const Note& note)
-		: NoteCommand(text, parent, note)
+	AddCommand(const QString& text, MainWindow& parent, Note note)
+		: NoteCommand(text, parent, std::move(note))
 	{
 	}
 };
@@ -154,8 +466,8 @@ protected:
 class MainWindow::RemoveCommand : public AddCommand
 {
 public:
-	RemoveCommand(MainWindow& parent, const Note& note)
-		: AddCommand("remove note", parent, note)
+	RemoveCommand(MainWindow& parent, Note note)
+		: AddCommand("remove note", parent, std::move(note))
 	{
 	}
 
@@ -170,63 +482,209 @@ public:
 	}
 };
 
-class MainWindow::RenameCommand : public QUndoCommand
+class MainWindow::RemoveNotesCommand : public HistoryCommand
 {
 public:
-	RenameCommand(MainWindow& parent, const Note& note, const std::string& oldName,
-		const std::string& newName)
-		: QUndoCommand("rename note"), m_parent(&parent), m_noteId(note.getId()),
-		  m_oldName(oldName), m_newName(newName)
+	RemoveNotesCommand(MainWindow& parent, std::vector<Note> notes)
+		: HistoryCommand(QString("remove %1 notes").arg(notes.size())), m_parent(&parent),
+		  m_removedNotes(std::move(notes))
 	{
 	}
 
+	size_t getPayloadSize() const override
+	{
+		size_t size = 0;
+		for (const Note& note : m_removedNotes)
+			size += note.getTitle().size() + note.getMessage().size();
+		return size;
+	}
+
 	void undo() override
 	{
+		if (isTrimmed())
+			return;
+
+		// All notes are reported to the list together once the batch ends.
 		NoteSet& noteSet = m_parent->m_notes->noteSet;
-		Note& note = *noteSet.find(m_noteId);
-		note.setTitle(m_oldName);
-		m_parent->updateCommands(note);
-		m_parent->sortNotes();
+		m_parent->m_impl->noteList->setUpdatesEnabled(false);
+		{
+			NoteSet::Batch batch(noteSet);
+			for (const Note& note : m_removedNotes)
+				noteSet.insert(noteSet.end(), note);
+		}
+		m_parent->m_impl->noteList->setUpdatesEnabled(true);
 
-		ptrdiff_t selectedNote = noteSet.find(m_noteId) - noteSet.begin();
-		m_parent->m_impl->noteList->setCurrentRow(static_cast<int>(selectedNote));
-		m_parent->markDirty();
+		uint64_t id = m_removedNotes.front().getId();
+		m_parent->selectNote(id);
+		m_parent->updateForSelection(id);
 	}
 
 	void redo() override
 	{
+		if (isTrimmed())
+			return;
+
 		NoteSet& noteSet = m_parent->m_notes->noteSet;
-		Note& note = *noteSet.find(m_noteId);
-		note.setTitle(m_newName);
-		m_parent->updateCommands(note);
-		m_parent->sortNotes();
+		std::vector<uint64_t> ids;
+		ids.reserve(m_removedNotes.size());
+		for (Note& note : m_removedNotes)
+		{
+			// Skip notes that were removed since by merging changes made to the file on disk.
+			const Note* foundNote = noteSet.find_note(note.getId());
+			if (!foundNote)
+				continue;
+
+			note = *foundNote;
+			ids.push_back(note.getId());
+		}
 
-		ptrdiff_t selectedNote = noteSet.find(m_noteId) - noteSet.begin();
-		m_parent->m_impl->noteList->setCurrentRow(static_cast<int>(selectedNote));
-		m_parent->markDirty();
+		m_parent->m_impl->noteList->setUpdatesEnabled(false);
+		noteSet.erase(ids);
+		m_parent->m_impl->noteList->setUpdatesEnabled(true);
+	}
+
+protected:
+	void releasePayload() override
+	{
+		std::vector<Note>().swap(m_removedNotes);
 	}
 
 private:
+	MainWindow* m_parent;
+	std::vector<Note> m_removedNotes;
+};
+
+class MainWindow::RenameCommand : public HistoryCommand
+{
+public:
+	RenameCommand(MainWindow& parent, const Note& note, const std::string& oldName,
+		const std::string& newName)
+		: HistoryCommand("rename note"), m_parent(&parent), m_noteId(note.getId()),
+		  m_oldName(oldName), m_newName(newName)
+	{
+	}
+
+	size_t getPayloadSize() const override
+	{
+		return m_oldName.size() + m_newName.size();
+	}
+
+	void undo() override
+	{
+		setTitle(m_oldName);
+	}
+
+	void redo() override
+	{
+		setTitle(m_newName);
+	}
+
+protected:
+	void releasePayload() override
+	{
+		std::string().swap(m_oldName);
+		std::string().swap(m_newName);
+	}
+
+private:
+	void setTitle(const std::string& title)
+	{
+		if (isTrimmed())
+			return;
+
+		NoteSet& noteSet = m_parent->m_notes->noteSet;
+		NoteSet::iterator foundIter = noteSet.find(m_noteId);
+		if (foundIter == noteSet.end())
+			return;
+
+		noteSet.setTitle(foundIter, title);
+
+		m_parent->selectNote(m_noteId);
+	}
+
 	MainWindow* m_parent;
 	uint64_t m_noteId;
 	std::string m_oldName;
 	std::string m_newName;
 };
 
+class MainWindow::MoveCommand : public HistoryCommand
+{
+public:
+	// Each move is the id of a note along with the folder it was in.
+	using Move = std::pair<uint64_t, uint64_t>;
+
+	MoveCommand(MainWindow& parent, std::vector<Move> moves, uint64_t folderId)
+		: HistoryCommand(moves.size() == 1 ? QString("move note") :
+			QString("move %1 notes").arg(moves.size())), m_parent(&parent),
+		  m_moves(std::move(moves)), m_folderId(folderId)
+	{
+	}
+
+	size_t getPayloadSize() const override
+	{
+		return m_moves.size()*sizeof(Move);
+	}
+
+	void undo() override
+	{
+		setParents(false);
+	}
+
+	void redo() override
+	{
+		setParents(true);
+	}
+
+protected:
+	void releasePayload() override
+	{
+		std::vector<Move>().swap(m_moves);
+	}
+
+private:
+	void setParents(bool moveToFolder)
+	{
+		if (isTrimmed())
+			return;
+
+		std::vector<Move> parents;
+		if (moveToFolder)
+		{
+			parents.reserve(m_moves.size());
+			for (const Move& move : m_moves)
+				parents.emplace_back(move.first, m_folderId);
+		}
+		m_parent->m_notes->noteSet.setParents(moveToFolder ? parents : m_moves);
+
+		m_parent->selectNote(m_moves.front().first);
+	}
+
+	MainWindow* m_parent;
+	std::vector<Move> m_moves;
+	uint64_t m_folderId;
+};
+
 MainWindow::MainWindow()
-	: m_impl(new Ui::MainWindow), m_children(new ChildItems(this)), m_notes(new NoteContext),
-	m_ignoreSelectionChanges(false)
+	: m_impl(new Ui::MainWindow), m_children(new ChildItems(this)),
+	m_notes(new NoteContext(*this)), m_ignoreSelectionChanges(false),
+	m_undoMemoryBudget(cDefaultUndoMemoryBudget), m_lockIdleTime(cDefaultLockIdleTimeMs)
 {
 	m_impl->setupUi(this);
 	m_impl->splitter->setStretchFactor(0, 0);
 	m_impl->splitter->setStretchFactor(1, 1);
-
-	QStringList filter;
-	filter.append("Secure note files (*.secnote)");
-
-	m_children->fileDialog.setNameFilters(filter);
-	m_children->fileDialog.setDefaultSuffix(".secnote");
-	m_children->fileDialog.setDirectory(QDir::home());
+	m_impl->splitter->setStretchFactor(2, 1);
+	m_impl->noteList->setModel(&m_children->noteTreeModel);
+	m_impl->notePreview->setDocument(m_children->markdownPreview.getDocument());
+	m_impl->notePreview->setVisible(false);
+	m_children->markdownPreview.setFont(m_impl->noteText->font());
+	m_children->noteCompleter.reset(new NoteCompleter(m_impl->noteText,
+		m_children->noteVocabulary.getVocabulary()));
+
+	m_children->menuUpdateTimer.setSingleShot(true);
+	m_children->menuUpdateTimer.setInterval(0);
+	QObject::connect(&m_children->menuUpdateTimer, SIGNAL(timeout()),
+		this, SLOT(updateMenuItems()));
 
 	updateForDeselection();
 	updateMenuItems();
@@ -259,101 +717,221 @@ MainWindow::MainWindow()
 	QObject::connect(m_impl->actionDelete, SIGNAL(triggered()), this, SLOT(onDelete()));
 	QObject::connect(m_impl->actionSelectAll, SIGNAL(triggered()), this, SLOT(onSelectAll()));
 	QObject::connect(m_impl->actionAddNote, SIGNAL(triggered()), this, SLOT(onAddNote()));
+	QObject::connect(m_impl->actionAddFolder, SIGNAL(triggered()), this, SLOT(onAddFolder()));
 	QObject::connect(m_impl->actionRemoveNote, SIGNAL(triggered()), this, SLOT(onRemoveNote()));
 	QObject::connect(m_impl->actionPasswordGenerator, SIGNAL(triggered()),
 		this, SLOT(onPasswordGenerator()));
 	QObject::connect(m_impl->actionAbout, SIGNAL(triggered()), this, SLOT(onAbout()));
+	QObject::connect(m_impl->actionLock, SIGNAL(triggered()), this, SLOT(onLock()));
+	QObject::connect(m_impl->actionShowPreview, SIGNAL(toggled(bool)),
+		this, SLOT(onShowPreview(bool)));
 
 	// Buttons
 	QObject::connect(m_impl->addButton, SIGNAL(clicked()), this, SLOT(onAddNote()));
+	QObject::connect(m_impl->addFolderButton, SIGNAL(clicked()), this, SLOT(onAddFolder()));
 	QObject::connect(m_impl->removeButton, SIGNAL(clicked()), this, SLOT(onRemoveNote()));
 
 	// Note list
-	QObject::connect(m_impl->noteList, SIGNAL(itemChanged(QListWidgetItem*)), this,
-		SLOT(onNoteRenamed(QListWidgetItem*)));
-	QObject::connect(m_impl->noteList, SIGNAL(itemSelectionChanged()), this,
+	QObject::connect(&m_children->noteTreeModel, SIGNAL(titleEdited(quint64, const QString&)),
+		this, SLOT(onNoteRenamed(quint64, const QString&)));
+	QObject::connect(&m_children->noteTreeModel,
+		SIGNAL(notesDropped(const QList<quint64>&, quint64)), this,
+		SLOT(onNotesDropped(const QList<quint64>&, quint64)));
+	QObject::connect(m_impl->noteList->selectionModel(),
+		SIGNAL(selectionChanged(const QItemSelection&, const QItemSelection&)), this,
 		SLOT(onNoteSelectionChanged()));
 
 	// Note text
-	QObject::connect(m_impl->noteText, SIGNAL(textChanged()), this, SLOT(onNoteTextChanged()));
-
-	// Timer
-	QObject::connect(&m_children->timer, SIGNAL(timeout()), this, SLOT(updateMenuItems()));
-	m_children->timer.start(1);
+	QObject::connect(m_impl->notePreview, SIGNAL(anchorClicked(const QUrl&)),
+		this, SLOT(onPreviewLinkClicked(const QUrl&)));
+
+	// Menu item state
+	QObject::connect(qApp, SIGNAL(focusChanged(QWidget*, QWidget*)),
+		this, SLOT(onFocusChanged(QWidget*, QWidget*)));
+	QObject::connect(m_impl->noteText, SIGNAL(textChanged()), this, SLOT(scheduleMenuUpdate()));
+	QObject::connect(m_impl->noteText, SIGNAL(selectionChanged()),
+		this, SLOT(scheduleMenuUpdate()));
+	QObject::connect(m_impl->noteText, SIGNAL(undoAvailable(bool)),
+		this, SLOT(scheduleMenuUpdate()));
+	QObject::connect(m_impl->noteText, SIGNAL(redoAvailable(bool)),
+		this, SLOT(scheduleMenuUpdate()));
+	QObject::connect(&m_children->undoStack, SIGNAL(indexChanged(int)),
+		this, SLOT(scheduleMenuUpdate()));
+	QObject::connect(&m_children->undoStack, SIGNAL(indexChanged(int)),
+		this, SLOT(onUndoIndexChanged(int)));
+	QObject::connect(&m_children->undoStack, SIGNAL(canUndoChanged(bool)),
+		this, SLOT(scheduleMenuUpdate()));
+	QObject::connect(&m_children->undoStack, SIGNAL(canRedoChanged(bool)),
+		this, SLOT(scheduleMenuUpdate()));
+
+	m_children->compactTimer.setSingleShot(true);
+	m_children->compactTimer.setInterval(cCompactIdleTimeMs);
+	QObject::connect(&m_children->compactTimer, SIGNAL(timeout()), this, SLOT(onCompactNotes()));
+
+	m_children->loadTimer.setInterval(0);
+	QObject::connect(&m_children->loadTimer, SIGNAL(timeout()), this, SLOT(onLoadNoteChunk()));
+	QObject::connect(&m_children->openWatcher, SIGNAL(resultsReadyAt(int, int)),
+		this, SLOT(onOpenNotesReady(int, int)));
+	QObject::connect(&m_children->openWatcher, SIGNAL(finished()), this, SLOT(onOpenFinished()));
+
+	m_children->openProgress = new QProgressBar(this);
+	m_children->openProgress->setMaximumWidth(200);
+	m_children->openProgress->setTextVisible(false);
+	m_children->openProgress->setVisible(false);
+	statusBar()->addPermanentWidget(m_children->openProgress);
+	QObject::connect(&m_children->openWatcher, SIGNAL(progressRangeChanged(int, int)),
+		m_children->openProgress, SLOT(setRange(int, int)));
+	QObject::connect(&m_children->openWatcher, SIGNAL(progressValueChanged(int)),
+		m_children->openProgress, SLOT(setValue(int)));
+
+	m_children->fileCheckTimer.setSingleShot(true);
+	m_children->fileCheckTimer.setInterval(cFileCheckDelayMs);
+	QObject::connect(&m_children->fileWatcher, SIGNAL(fileChanged(const QString&)),
+		this, SLOT(onFileChanged()));
+	QObject::connect(&m_children->fileCheckTimer, SIGNAL(timeout()), this, SLOT(onCheckFile()));
+	QObject::connect(&m_children->reloadWatcher, SIGNAL(finished()),
+		this, SLOT(onReloadFinished()));
+
+	QObject::connect(&m_children->autoSaver, SIGNAL(saveRequested()), this, SLOT(onAutoSave()));
+	QObject::connect(&m_children->autoSaver, SIGNAL(saved(bool)), this, SLOT(onAutoSaved(bool)));
+	QObject::connect(&m_children->autoSaver, SIGNAL(saveFailed()),
+		this, SLOT(onAutoSaveFailed()));
+
+	m_impl->unlockButton->setVisible(false);
+	QObject::connect(m_impl->unlockButton, SIGNAL(clicked()), this, SLOT(onLock()));
+
+	// Input anywhere in the application counts as activity for the idle lock.
+	m_children->lockTimer.setSingleShot(true);
+	m_children->lockTimer.setInterval(m_lockIdleTime);
+	QObject::connect(&m_children->lockTimer, SIGNAL(timeout()), this, SLOT(onLockIdle()));
+	m_children->lockTimer.start();
+	qApp->installEventFilter(this);
 }
 
 MainWindow::~MainWindow()
 {
+	qApp->removeEventFilter(this);
+
+	// The editor and preview don't own their documents, so make sure they don't outlive them.
+	setNoteDocument(nullptr);
+	m_impl->notePreview->setDocument(nullptr);
+}
+
+void MainWindow::setUndoMemoryBudget(size_t bytes)
+{
+	m_undoMemoryBudget = bytes;
+	trimUndoHistory();
 }
 
-bool MainWindow::open(const std::string& filePath)
+bool MainWindow::hasFile(const std::string& filePath) const
 {
-	FileIStream stream;
-	if (!stream.open(filePath))
+	return m_notes->savePath == filePath ||
+		(m_children->openTask && m_children->openTask->filePath == filePath);
+}
+
+bool MainWindow::isOpening() const
+{
+	return m_children->openTask != nullptr;
+}
+
+bool MainWindow::isUnused() const
+{
+	return m_notes->savePath.empty() && !m_notes->dirty && !m_notes->locked &&
+		m_notes->noteSet.size() == 0 && !m_children->openTask;
+}
+
+bool MainWindow::isLocked() const
+{
+	return m_notes->locked;
+}
+
+bool MainWindow::canLock() const
+{
+	return !m_notes->locked && !m_notes->key.empty();
+}
+
+bool MainWindow::lock()
+{
+	if (m_notes->locked)
+		return true;
+	if (!canLock())
+		return false;
+
+	// Tasks still loading the file would otherwise deliver their notes after the key is gone.
+	cancelOpen();
+	cancelReload();
+
+	// The image is encrypted with the current key, so unlocking only needs to derive the key again
+	// and decrypt from memory rather than reading and parsing the file.
+	MemoryOStream stream;
+	if (NoteFile::saveNotes(m_notes->noteSet, stream, m_notes->salt, m_notes->key) !=
+		NoteFile::Result::Success)
 	{
-		std::string message = "Couldn't open file '" + filePath + "'";
-		QMessageBox::warning(this, "Couldn't Open", message.c_str());
+		QMessageBox::warning(this, "Couldn't Lock", "Error encrypting notes");
 		return false;
 	}
 
-	NoteFile::Result result = NoteFile::Result::Success;
+	// The undo history, editor documents, and autosave snapshots hold copies of the text, so
+	// they're released along with the notes. Note text is cleansed as the last reference to it is
+	// released, so wait for a save in progress to let go of its copy. Text that Qt copied, such as
+	// in the editor and preview documents and the completions, is only freed, not cleansed.
+	// Pending autosaves are dropped since there's nothing left to save from; they are scheduled
+	// again when unlocking.
+	m_children->undoStack.clear();
+	m_children->autoSaver.reset();
+	m_children->autoSaver.waitForSave();
+	m_notes->lockedImage = stream.release();
+	m_notes->noteSet = NoteSet();
+	Crypto::cleanse(m_notes->key);
+	m_notes->locked = true;
+
+	updateUi();
+	updateLockState();
+	return true;
+}
+
+bool MainWindow::unlock()
+{
+	if (!m_notes->locked)
+		return true;
 
+	NoteFile::Result result = NoteFile::Result::Success;
 	do
 	{
-		if (!m_children->openPasswordDialog.exec())
+		OpenPasswordDialog& openPasswordDialog = m_children->getOpenPasswordDialog();
+		if (!openPasswordDialog.exec())
 			return false;
 
-		// Need to re-open the file if retrying.
-		if (result != NoteFile::Result::Success)
-		{
-			if (!stream.open(filePath))
-			{
-				std::string message = "Couldn't open file '" + filePath + "'";
-				QMessageBox::warning(this, "Couldn't Open", message.c_str());
-				return false;
-			}
-		}
-
-		std::string password = m_children->openPasswordDialog.getPassword();
+		std::string password = openPasswordDialog.getPassword();
 		assert(!password.empty());
 
-		QFileInfo fileInfo(filePath.c_str());
-		std::string fileName = fileInfo.fileName().toStdString();
-		size_t extensionPos = fileName.find_last_of('.');
-		if (extensionPos != std::string::npos)
-			fileName = fileName.substr(0, extensionPos);
-
+		MemoryIStream stream(m_notes->lockedImage.data(), m_notes->lockedImage.size());
 		std::vector<uint8_t> salt, key;
 		NoteSet noteSet;
+		noteSet.setStorageMode(NoteSet::StorageMode::Arena);
 		result = NoteFile::loadNotes(noteSet, stream, password, salt, key);
 		switch (result)
 		{
 			case NoteFile::Result::Success:
-				clear();
-				m_notes->noteSet = noteSet;
-				m_notes->savePath = filePath;
-				m_notes->fileName = fileName;
-				m_notes->salt = salt;
-				m_notes->key = key;
-
-				updateTitle();
+				m_notes->noteSet = std::move(noteSet);
+				m_notes->key = std::move(key);
+				m_notes->lockedImage.clear();
+				m_notes->lockedImage.shrink_to_fit();
+				m_notes->locked = false;
+
+				updateLockState();
 				updateUi();
+				if (m_notes->dirty)
+					m_children->autoSaver.notesModified();
+
+				// Catch up on changes made to the file while locked.
+				m_children->fileCheckTimer.start();
 				return true;
-			case NoteFile::Result::InvalidFile:
-				QMessageBox::warning(this, "Couldn't Open", "Invalid file format");
-				break;
-			case NoteFile::Result::InvalidVersion:
-				QMessageBox::warning(this, "Couldn't Open",
-					"File version is too new. Please update Note Vault.");
-				break;
-			case NoteFile::Result::IoError:
-				QMessageBox::warning(this, "Couldn't Open", "Error reading file");
-				break;
 			case NoteFile::Result::EncryptionError:
-				QMessageBox::warning(this, "Couldn't Open", "Incorrect password");
+				QMessageBox::warning(this, "Couldn't Unlock", "Incorrect password");
 				break;
 			default:
-				assert(false);
+				QMessageBox::warning(this, "Couldn't Unlock", "Error decrypting notes");
 				break;
 		}
 	} while (result == NoteFile::Result::EncryptionError);
@@ -361,11 +939,226 @@ bool MainWindow::open(const std::string& filePath)
 	return false;
 }
 
+void MainWindow::setLockIdleTime(int ms)
+{
+	m_lockIdleTime = std::max(ms, 0);
+	if (m_lockIdleTime == 0)
+	{
+		m_children->lockTimer.stop();
+		return;
+	}
+
+	m_children->lockTimer.setInterval(m_lockIdleTime);
+	if (!m_notes->locked)
+		m_children->lockTimer.start();
+}
+
+bool MainWindow::open(const std::string& filePath)
+{
+	// Check that the file can be read before asking for the password.
+	FileIStream stream;
+	if (!stream.open(filePath))
+	{
+		std::string message = "Couldn't open file '" + filePath + "'";
+		QMessageBox::warning(this, "Couldn't Open", message.c_str());
+		Q_EMIT openFinished(false);
+		return false;
+	}
+	stream.close();
+
+	// Read the file and parse its header while the user types the password, leaving only deriving
+	// the key and decrypting once it's entered. The contents are kept in case the password needs
+	// to be entered again, unless the file has changed since.
+	if (m_children->readAheadPath == filePath && m_children->readAhead.isFinished() &&
+		!isFileImageCurrent(*m_children->readAhead.result(), filePath))
+	{
+		m_children->readAheadPath.clear();
+	}
+
+	if (m_children->readAheadPath != filePath)
+	{
+		std::shared_ptr<QPromise<std::shared_ptr<const FileImage>>> imagePromise =
+			std::make_shared<QPromise<std::shared_ptr<const FileImage>>>();
+		imagePromise->start();
+		m_children->readAhead = imagePromise->future();
+		m_children->readAheadPath = filePath;
+		QThreadPool::globalInstance()->start([imagePromise, filePath]()
+			{
+				imagePromise->addResult(readFileImage(filePath));
+				imagePromise->finish();
+			});
+	}
+
+	OpenPasswordDialog& openPasswordDialog = m_children->getOpenPasswordDialog();
+	StartupTrace::mark("password prompt");
+	if (!openPasswordDialog.exec())
+	{
+		m_children->readAhead = FileImageFuture();
+		m_children->readAheadPath.clear();
+		Q_EMIT openFinished(false);
+		return false;
+	}
+
+	std::string password = openPasswordDialog.getPassword();
+	assert(!password.empty());
+	cancelOpen();
+
+	// Deriving the key and decrypting happen on the shared thread pool, so other windows can
+	// prompt for their passwords or finish opening in the meantime.
+	std::shared_ptr<OpenTask> task = std::make_shared<OpenTask>();
+	task->filePath = filePath;
+	task->password = std::move(password);
+	task->noteSet.setStorageMode(NoteSet::StorageMode::Arena);
+	task->result = NoteFile::Result::Success;
+	task->batchCount = 0;
+	task->populated = false;
+
+	m_children->openTask = task;
+	m_children->openWatcher.setFuture(task->promise.future());
+	statusBar()->showMessage(QString("Opening %1...").arg(QString::fromStdString(filePath)));
+	m_children->openProgress->setRange(0, 0);
+	m_children->openProgress->setVisible(true);
+	scheduleMenuUpdate();
+
+	// Continue once the read finishes rather than waiting for it, which would hold a thread of the
+	// shared pool that the read itself may still need.
+	m_children->readAhead.then(QThreadPool::globalInstance(),
+		[task](std::shared_ptr<const FileImage> image)
+		{
+			task->promise.start();
+
+			// The file may have been changed while the password was entered.
+			if (!isFileImageCurrent(*image, task->filePath))
+				image = readFileImage(task->filePath);
+			task->result = image->result;
+			if (task->result == NoteFile::Result::Success)
+			{
+				// Only notes after the ones already published are copied into the next batch. The
+				// copies share the text with the notes kept for hashing.
+				size_t published = 0;
+				size_t batchSize = cFirstOpenBatchSize;
+				auto publishNotes = [&task, &published, &batchSize] (const NoteSet& notes,
+					uint32_t totalNotes)
+					{
+						// Stop decrypting once the open is canceled rather than holding the key and
+						// notes until the whole file is read.
+						if (task->promise.isCanceled())
+							return false;
+						if (notes.size() == 0)
+							task->promise.setProgressRange(0, toProgress(totalNotes));
+						if (notes.size() == published ||
+							(notes.size() - published < batchSize && notes.size() != totalNotes))
+						{
+							return true;
+						}
+
+						NoteBatch batch = std::make_shared<std::vector<Note>>();
+						batch->reserve(notes.size() - published);
+						for (size_t i = published; i < notes.size(); ++i)
+							batch->push_back(notes[i]);
+						std::sort(batch->begin(), batch->end(), compareTitles);
+						task->promise.addResult(std::move(batch));
+						task->promise.setProgressValue(toProgress(notes.size()));
+
+						published = notes.size();
+						batchSize = std::min(batchSize*2, cMaxOpenBatchSize);
+						return true;
+					};
+
+				MemoryIStream stream(image->data.data() + image->headerSize,
+					image->data.size() - image->headerSize);
+				task->result = NoteFile::loadNotes(task->noteSet, stream, image->header,
+					task->password, task->key, publishNotes);
+				task->salt = image->header.salt;
+			}
+
+			if (task->result == NoteFile::Result::Success)
+				NoteHash::hash(task->noteSet, task->noteHashes);
+			else if (task->result == NoteFile::Result::Canceled)
+			{
+				task->noteSet = NoteSet();
+				Crypto::cleanse(task->key);
+			}
+			task->password.assign(task->password.size(), 0);
+			task->promise.finish();
+		});
+	return true;
+}
+
+void MainWindow::onOpenNotesReady(int, int)
+{
+	if (m_children->openTask)
+		populateNotes();
+}
+
+void MainWindow::onOpenFinished()
+{
+	if (!m_children->openTask)
+		return;
+
+	// Add any batches that haven't been handled yet before the task is dropped.
+	if (m_children->openTask->result == NoteFile::Result::Success)
+		populateNotes();
+
+	std::shared_ptr<OpenTask> task = std::move(m_children->openTask);
+	statusBar()->clearMessage();
+	m_children->openProgress->setVisible(false);
+	scheduleMenuUpdate();
+
+	// Only keep the file contents around when the password needs to be entered again.
+	if (task->result != NoteFile::Result::EncryptionError)
+	{
+		m_children->readAhead = FileImageFuture();
+		m_children->readAheadPath.clear();
+	}
+
+	const std::string& filePath = task->filePath;
+	switch (task->result)
+	{
+		case NoteFile::Result::Success:
+			m_notes->salt = std::move(task->salt);
+			m_notes->key = std::move(task->key);
+			m_notes->fileNoteHashes = std::move(task->noteHashes);
+			rootUnrootedNotes();
+			m_notes->populating = false;
+			m_children->noteTreeModel.setEditable(true);
+			m_impl->noteText->setReadOnly(m_children->loadingNoteId != NoteChange::cNoId);
+			watchFile();
+			Q_EMIT openFinished(true);
+			return;
+		case NoteFile::Result::InvalidFile:
+			QMessageBox::warning(this, "Couldn't Open", "Invalid file format");
+			break;
+		case NoteFile::Result::InvalidVersion:
+			QMessageBox::warning(this, "Couldn't Open",
+				"File version is too new. Please update Note Vault.");
+			break;
+		case NoteFile::Result::IoError:
+			QMessageBox::warning(this, "Couldn't Open", "Error reading file");
+			break;
+		case NoteFile::Result::EncryptionError:
+			// The password is checked before any notes are decrypted, so nothing was shown yet.
+			QMessageBox::warning(this, "Couldn't Open", "Incorrect password");
+			// Ask for the password again.
+			open(filePath);
+			return;
+		default:
+			assert(false);
+			break;
+	}
+
+	// Notes shown before the error are only part of the file.
+	if (task->populated)
+		clear();
+	Q_EMIT openFinished(false);
+}
+
 void MainWindow::onNew()
 {
 	if (!canClose())
 		return;
 
+	cancelOpen();
 	clear();
 }
 
@@ -374,14 +1167,15 @@ void MainWindow::onOpen()
 	if (!canClose())
 		return;
 
-	m_children->fileDialog.setAcceptMode(QFileDialog::AcceptOpen);
-	m_children->fileDialog.setFileMode(QFileDialog::ExistingFile);
-	m_children->fileDialog.setWindowTitle("Open Notes");
+	QFileDialog& fileDialog = m_children->getFileDialog();
+	fileDialog.setAcceptMode(QFileDialog::AcceptOpen);
+	fileDialog.setFileMode(QFileDialog::ExistingFile);
+	fileDialog.setWindowTitle("Open Notes");
 
-	if (!m_children->fileDialog.exec())
+	if (!fileDialog.exec())
 		return;
 
-	QStringList selectedFile = m_children->fileDialog.selectedFiles();
+	QStringList selectedFile = fileDialog.selectedFiles();
 	open(selectedFile[0].toStdString());
 }
 
@@ -439,76 +1233,497 @@ void MainWindow::onDelete()
 	}
 }
 
-void MainWindow::onSelectAll()
+void MainWindow::onSelectAll()
+{
+	QObject* textEdit = getCurrentTextEdit();
+	if (textEdit)
+		QMetaObject::invokeMethod(textEdit, "selectAll");
+}
+
+void MainWindow::onAddNote()
+{
+	addNote(false);
+}
+
+void MainWindow::onAddFolder()
+{
+	addNote(true);
+}
+
+void MainWindow::onRemoveNote()
+{
+	if (m_notes->selectedNote == NoteSet::iterator())
+		return;
+
+	// Removing a folder also removes everything inside of it.
+	const NoteTree& tree = m_children->noteTreeModel.getTree();
+	std::vector<uint64_t> ids;
+	QModelIndexList selectedRows = m_impl->noteList->selectionModel()->selectedRows();
+	if (selectedRows.empty())
+		selectedRows.append(m_impl->noteList->currentIndex());
+	for (const QModelIndex& index : selectedRows)
+	{
+		uint64_t id = m_children->noteTreeModel.getNoteId(index);
+		if (id == Note::cNoParent)
+			continue;
+
+		ids.push_back(id);
+		tree.getDescendants(ids, id);
+	}
+
+	// Notes inside of selected folders may also be selected themselves.
+	std::unordered_set<uint64_t> removedIds;
+	std::vector<Note> notes;
+	notes.reserve(ids.size());
+	for (uint64_t id : ids)
+	{
+		if (!removedIds.insert(id).second)
+			continue;
+
+		if (const Note* note = m_notes->noteSet.find_note(id))
+			notes.push_back(*note);
+	}
+
+	if (notes.empty())
+		return;
+	else if (notes.size() == 1)
+		pushCommand(new RemoveCommand(*this, std::move(notes.front())));
+	else
+		pushCommand(new RemoveNotesCommand(*this, std::move(notes)));
+}
+
+void MainWindow::onAbout()
+{
+	AboutDialog& aboutDialog = m_children->getAboutDialog();
+	aboutDialog.show();
+	aboutDialog.raise();
+	aboutDialog.activateWindow();
+}
+
+void MainWindow::onLock()
+{
+	if (m_notes->locked)
+		unlock();
+	else
+		lock();
+}
+
+void MainWindow::onPasswordGenerator()
+{
+	GeneratePasswordDialog& generatePasswordDialog = m_children->getGeneratePasswordDialog();
+	generatePasswordDialog.generatePassword();
+	generatePasswordDialog.show();
+	generatePasswordDialog.raise();
+	generatePasswordDialog.activateWindow();
+}
+
+void MainWindow::onNoteRenamed(quint64 id, const QString& title)
+{
+	const Note* note = m_notes->noteSet.find_note(id);
+	if (!note)
+		return;
+
+	std::string oldName = note->getTitle().str();
+	std::string newName = title.toStdString();
+	if (newName == oldName)
+		return;
+
+	pushCommand(new RenameCommand(*this, *note, oldName, newName));
+}
+
+void MainWindow::onNotesDropped(const QList<quint64>& ids, quint64 folderId)
+{
+	// Folders can't be moved inside of themselves.
+	const NoteTree& tree = m_children->noteTreeModel.getTree();
+	std::vector<MoveCommand::Move> moves;
+	for (quint64 id : ids)
+	{
+		const Note* note = m_notes->noteSet.find_note(id);
+		if (!note || note->getParentId() == folderId)
+			continue;
+
+		bool insideNote = false;
+		for (uint64_t parentId = folderId; parentId != Note::cNoParent;
+			parentId = tree.getParent(parentId))
+		{
+			if (parentId == id)
+			{
+				insideNote = true;
+				break;
+			}
+		}
+
+		if (!insideNote)
+			moves.emplace_back(id, note->getParentId());
+	}
+
+	if (!moves.empty())
+		pushCommand(new MoveCommand(*this, std::move(moves), folderId));
+}
+
+void MainWindow::onNoteSelectionChanged()
+{
+	// With multiple notes selected, the current note is shown if it's part of the selection.
+	QItemSelectionModel* selectionModel = m_impl->noteList->selectionModel();
+	QModelIndex currentIndex = selectionModel->currentIndex();
+	if (currentIndex.isValid() && selectionModel->isSelected(currentIndex))
+		updateForSelection(m_children->noteTreeModel.getNoteId(currentIndex));
+	else
+	{
+		QModelIndexList selectedRows = selectionModel->selectedRows();
+		if (selectedRows.empty())
+			updateForDeselection();
+		else
+			updateForSelection(m_children->noteTreeModel.getNoteId(selectedRows[0]));
+	}
+}
+
+void MainWindow::onShowPreview(bool show)
+{
+	// The preview is only kept up to date while it's shown.
+	m_children->markdownPreview.setEnabled(show);
+	m_impl->notePreview->setVisible(show);
+}
+
+void MainWindow::onPreviewLinkClicked(const QUrl& url)
+{
+	// Links without a scheme would otherwise be loaded into the preview in place of the note.
+	if (!url.isRelative())
+		QDesktopServices::openUrl(url);
+}
+
+void MainWindow::onNoteTextChanged(int position, int charsRemoved, int charsAdded)
+{
+	if (m_ignoreSelectionChanges || m_notes->selectedNote == NoteSet::iterator())
+		return;
+
+	// A note that's still loading is read-only, so its document only changes from loading and
+	// highlighting, and doesn't match the note yet.
+	if (m_children->loadingNoteId == m_notes->selectedNoteId)
+		return;
+
+	// Only the edited range is applied to the note, so the cost of an edit doesn't depend on the
+	// size of the note. The change may include the paragraph separator at the end of the document,
+	// which isn't part of the note's text.
+	QTextDocument* document = m_impl->noteText->document();
+	const NoteBody& message = m_notes->selectedNote->getMessage();
+	size_t oldLength = message.utf16Size();
+	size_t newLength = static_cast<size_t>(std::max(document->characterCount() - 1, 0));
+	size_t start = static_cast<size_t>(position);
+	size_t removedEnd = std::min(start + static_cast<size_t>(charsRemoved), oldLength);
+	size_t addedEnd = std::min(start + static_cast<size_t>(charsAdded), newLength);
+	if (position < 0 || start > removedEnd || start > addedEnd ||
+		oldLength - (removedEnd - start) + (addedEnd - start) != newLength)
+	{
+		// Fall back to copying the full text if the change doesn't line up with the note.
+		m_notes->noteSet.setMessage(m_notes->selectedNote,
+			m_impl->noteText->toPlainText().toStdString());
+		return;
+	}
+
+	QTextCursor cursor(document);
+	cursor.setPosition(position);
+	cursor.setPosition(static_cast<int>(addedEnd), QTextCursor::KeepAnchor);
+	QByteArray added = toPlainText(cursor.selectedText()).toUtf8();
+
+	size_t offset = message.utf16ToOffset(start);
+	size_t removedLength = message.utf16ToOffset(removedEnd) - offset;
+	size_t addedLength = static_cast<size_t>(added.size());
+
+	// Formatting changes report the same text as both removed and added.
+	if (removedLength == addedLength &&
+		message.substr(offset, removedLength).compare(0, addedLength, added.constData(),
+			addedLength) == 0)
+	{
+		return;
+	}
+
+	m_children->noteVocabulary.replaceMessage(*m_notes->selectedNote, offset, removedLength,
+		added.constData(), addedLength);
+	m_notes->noteSet.replaceMessage(m_notes->selectedNote, offset, removedLength,
+		added.constData(), addedLength);
+}
+
+void MainWindow::onCompactNotes()
+{
+	// The notes being opened share blocks that are still being filled on the worker thread.
+	if (m_notes->populating)
+		return;
+
+	m_notes->noteSet.compact();
+}
+
+void MainWindow::onLoadNoteChunk()
+{
+	QTextDocument* document = m_children->documentCache.find(m_children->loadingNoteId);
+	const Note* note = m_notes->noteSet.find_note(m_children->loadingNoteId);
+	if (!document || !note)
+	{
+		cancelNoteLoad();
+		return;
+	}
+
+	bool ignoreSelectionChanges = m_ignoreSelectionChanges;
+	m_ignoreSelectionChanges = true;
+	bool finished = loadNoteChunk(*document, note->getMessage());
+	m_ignoreSelectionChanges = ignoreSelectionChanges;
+
+	if (finished)
+		finishNoteLoad(*document);
+}
+
+void MainWindow::onAutoSave()
+{
+	// Notes that have never been saved don't have a file or key to save with yet.
+	if (m_notes->savePath.empty() || m_notes->key.empty())
+		return;
+
+	// Merge in changes made to the file by other programs first rather than overwriting them.
+	if (m_notes->reloading || m_children->reloadTask || !isFileStampCurrent())
+	{
+		m_children->autoSaver.notesModified();
+		m_children->fileCheckTimer.start();
+		return;
+	}
+
+	if (m_children->autoSaver.save(m_notes->noteSet, m_notes->savePath, m_notes->salt,
+			m_notes->key))
+	{
+		m_notes->autoSavingIds.insert(m_notes->modifiedIds.begin(), m_notes->modifiedIds.end());
+		m_notes->modifiedIds.clear();
+	}
+}
+
+void MainWindow::onAutoSaved(bool upToDate)
+{
+	m_notes->fileNoteHashes = m_children->autoSaver.getSavedNoteHashes();
+	m_notes->autoSavingIds.clear();
+	updateFileStamp();
+
+	if (!upToDate || !m_notes->dirty)
+		return;
+
+	m_notes->dirty = false;
+	updateTitle();
+}
+
+void MainWindow::onAutoSaveFailed()
+{
+	// Leave the notes marked as modified so they're still saved explicitly before closing.
+	m_notes->modifiedIds.insert(m_notes->autoSavingIds.begin(), m_notes->autoSavingIds.end());
+	m_notes->autoSavingIds.clear();
+	statusBar()->showMessage("Couldn't autosave notes", cAutoSaveMessageTimeMs);
+}
+
+void MainWindow::onFileChanged()
 {
-	QObject* textEdit = getCurrentTextEdit();
-	if (textEdit)
-		QMetaObject::invokeMethod(textEdit, "selectAll");
+	// Wait for the other program to finish writing.
+	m_children->fileCheckTimer.start();
 }
 
-void MainWindow::onAddNote()
+void MainWindow::onCheckFile()
 {
-	NoteSet::iterator newNoteIter = m_notes->noteSet.insert(m_notes->noteSet.end());
-	Note newNote = *newNoteIter;
-	m_notes->noteSet.erase(newNoteIter);
+	if (m_notes->savePath.empty())
+		return;
 
-	newNote.setTitle("New note");
-	m_children->undoStack.push(new AddCommand(*this, newNote));
+	// Some programs replace the file rather than writing to it, which stops it being watched.
+	QString filePath = QString::fromStdString(m_notes->savePath);
+	QFileInfo fileInfo(filePath);
+	if (!fileInfo.exists())
+		return;
+	if (!m_children->fileWatcher.files().contains(filePath))
+		m_children->fileWatcher.addPath(filePath);
 
-	ptrdiff_t newItemIndex = m_notes->selectedNote - m_notes->noteSet.begin();
-	QListWidgetItem* newItem = m_impl->noteList->item(static_cast<int>(newItemIndex));
-	m_impl->noteList->editItem(newItem);
-}
+	if (isFileStampCurrent())
+		return;
 
-void MainWindow::onRemoveNote()
-{
-	if (m_notes->selectedNote == NoteSet::iterator())
+	// The key is needed to reload, and the file shouldn't be read while being written. A reload
+	// that's still waiting on a prompt hasn't recorded the file it merged yet.
+	if (m_notes->locked || m_notes->reloading || m_children->openTask ||
+		m_children->reloadTask || m_children->autoSaver.isSaving())
+	{
+		m_children->fileCheckTimer.start();
 		return;
+	}
 
-	m_children->undoStack.push(new RemoveCommand(*this, *m_notes->selectedNote));
-}
+	std::shared_ptr<ReloadTask> task = std::make_shared<ReloadTask>();
+	task->filePath = m_notes->savePath;
+	task->salt = m_notes->salt;
+	task->key = m_notes->key;
+	task->fileSize = fileInfo.size();
+	task->fileModified = fileInfo.lastModified();
+	task->noteSet.setStorageMode(NoteSet::StorageMode::Arena);
+	task->result = NoteFile::Result::Success;
+	task->keyChanged = false;
+
+	m_children->reloadTask = task;
+	m_children->reloadWatcher.setFuture(task->promise.future());
+	QThreadPool::globalInstance()->start([task]()
+		{
+			task->promise.start();
+			FileIStream stream;
+			NoteFile::Header header;
+			if (!stream.open(task->filePath))
+				task->result = NoteFile::Result::IoError;
+			else
+				task->result = NoteFile::readHeader(header, stream);
+
+			if (task->result == NoteFile::Result::Success)
+			{
+				if (header.salt != task->salt ||
+					header.getKeyIterations() != Crypto::cDefaultKeyIterations)
+				{
+					task->keyChanged = true;
+					task->result = NoteFile::Result::EncryptionError;
+				}
+				else
+				{
+					task->result = NoteFile::loadNotes(task->noteSet, stream, header, task->key,
+						[&task](const NoteSet&, uint32_t)
+						{
+							return !task->promise.isCanceled();
+						});
+				}
+			}
 
-void MainWindow::onAbout()
-{
-	m_children->aboutDialog.show();
-	m_children->aboutDialog.raise();
-	m_children->aboutDialog.activateWindow();
+			if (task->result == NoteFile::Result::Success)
+				NoteHash::hash(task->noteSet, task->noteHashes);
+			Crypto::cleanse(task->key);
+			task->promise.finish();
+		});
 }
 
-void MainWindow::onPasswordGenerator()
+void MainWindow::onReloadFinished()
 {
-	m_children->generatePasswordDialog.generatePassword();
-	m_children->generatePasswordDialog.show();
-	m_children->generatePasswordDialog.raise();
-	m_children->generatePasswordDialog.activateWindow();
+	std::shared_ptr<ReloadTask> task = std::move(m_children->reloadTask);
+	if (!task || task->filePath != m_notes->savePath || m_notes->locked)
+		return;
+
+	if (task->result != NoteFile::Result::Success)
+	{
+		if (!task->keyChanged)
+		{
+			// Likely caught while still being written; the next change will try again.
+			statusBar()->showMessage("Couldn't reload notes changed on disk",
+				cAutoSaveMessageTimeMs);
+			return;
+		}
+
+		m_notes->fileSize = task->fileSize;
+		m_notes->fileModified = task->fileModified;
+		m_notes->reloading = true;
+		bool reopen = QMessageBox::question(this, "Notes Changed on Disk",
+			"The notes file was saved with a different password by another program. Open it "
+			"again? Changes that haven't been saved will be lost.") == QMessageBox::Yes;
+		m_notes->reloading = false;
+		if (reopen)
+			open(m_notes->savePath);
+		return;
+	}
+
+	// Keep autosaves from writing the file and other reloads from starting while a conflict is
+	// being resolved. The file checked while the prompt is shown is checked again afterward.
+	m_notes->reloading = true;
+	std::unordered_set<uint64_t> modifiedIds = m_notes->modifiedIds;
+	modifiedIds.insert(m_notes->autoSavingIds.begin(), m_notes->autoSavingIds.end());
+	NoteMerge::Result merge;
+	NoteMerge::diff(merge, m_notes->noteSet, modifiedIds, m_notes->fileNoteHashes,
+		task->noteHashes);
+	if (!merge.conflicts.empty())
+	{
+		QString message = QString("%1 notes were changed both here and by another program. Keep "
+			"the changes made here?\n\nChoosing No uses the versions from the file.").arg(
+			merge.conflicts.size());
+		if (QMessageBox::question(this, "Notes Changed on Disk", message) == QMessageBox::Yes)
+			NoteMerge::keepLocal(merge);
+		else
+			NoteMerge::keepRemote(merge, task->noteSet);
+	}
+
+	uint64_t selectedId = m_notes->selectedNoteId;
+	bool selectedUpdated = selectedId != NoteChange::cNoId &&
+		std::find(merge.updated.begin(), merge.updated.end(), selectedId) != merge.updated.end();
+	bool changed = !merge.updated.empty() || !merge.removed.empty();
+	if (changed)
+	{
+		NoteMerge::apply(m_notes->noteSet, task->noteSet, merge);
+
+		// Undo commands refer to notes by id, which may no longer match what they expect.
+		m_children->undoStack.clear();
+
+		// Keep showing the note from here if it was moved to a new id to make room for an
+		// unrelated note from the file.
+		for (const std::pair<uint64_t, uint64_t>& duplicate : merge.duplicates)
+		{
+			if (duplicate.first == selectedId)
+			{
+				discardNoteDocument(selectedId);
+				selectNote(duplicate.second);
+				selectedUpdated = false;
+				break;
+			}
+		}
+	}
+	m_notes->reloading = false;
+
+	m_notes->fileNoteHashes = std::move(task->noteHashes);
+	m_notes->modifiedIds.clear();
+	m_notes->modifiedIds.insert(merge.pending.begin(), merge.pending.end());
+	m_notes->autoSavingIds.clear();
+	m_notes->fileSize = task->fileSize;
+	m_notes->fileModified = task->fileModified;
+	rootUnrootedNotes();
+
+	// Edits to the selected note normally come from its document, so load it again.
+	if (selectedUpdated && m_notes->noteSet.find_note(selectedId))
+	{
+		discardNoteDocument(selectedId);
+		updateForSelection(selectedId);
+	}
+
+	// The last autosave no longer matches the file, so it can't be used to skip saving.
+	m_children->autoSaver.reset();
+	m_notes->dirty = !m_notes->modifiedIds.empty();
+	updateTitle();
+	if (m_notes->dirty)
+		m_children->autoSaver.notesModified();
+	if (changed)
+		statusBar()->showMessage("Reloaded notes changed on disk", cAutoSaveMessageTimeMs);
 }
 
-void MainWindow::onNoteRenamed(QListWidgetItem* item)
+void MainWindow::onLockIdle()
 {
-	Note& note = m_notes->noteSet[m_impl->noteList->row(item)];
+	// Don't pull the notes out from under a dialog that's still open, such as when confirming a
+	// save. Check again after another idle period instead.
+	if (QApplication::activeModalWidget())
+	{
+		m_children->lockTimer.start();
+		return;
+	}
 
-	std::string oldName = note.getTitle();
-	std::string newName = item->text().toStdString();
-	m_children->undoStack.push(new RenameCommand(*this, note, oldName, newName));
+	lock();
 }
 
-void MainWindow::onNoteSelectionChanged()
+void MainWindow::onFocusChanged(QWidget* oldWidget, QWidget* newWidget)
 {
-	QList<QListWidgetItem*> selectedItems = m_impl->noteList->selectedItems();
-	if (selectedItems.empty())
-		updateForDeselection();
-	else
-		updateForSelection(m_impl->noteList->row(selectedItems[0]));
+	// Line edits, such as the editor when renaming a note, are only tracked while focused.
+	if (QLineEdit* lineEdit = dynamic_cast<QLineEdit*>(oldWidget))
+		QObject::disconnect(lineEdit, nullptr, this, nullptr);
+	if (QLineEdit* lineEdit = dynamic_cast<QLineEdit*>(newWidget))
+	{
+		QObject::connect(lineEdit, SIGNAL(textChanged(const QString&)),
+			this, SLOT(scheduleMenuUpdate()));
+		QObject::connect(lineEdit, SIGNAL(selectionChanged()), this, SLOT(scheduleMenuUpdate()));
+	}
+
+	scheduleMenuUpdate();
 }
 
-void MainWindow::onNoteTextChanged()
+void MainWindow::scheduleMenuUpdate()
 {
-	if (m_ignoreSelectionChanges || m_notes->selectedNote == NoteSet::iterator())
-		return;
-
-	m_notes->selectedNote->setMessage(m_impl->noteText->toPlainText().toStdString());
-	updateCommands(*m_notes->selectedNote);
-	markDirty();
+	// Coalesce bursts of changes into a single update once control returns to the event loop.
+	if (!m_children->menuUpdateTimer.isActive())
+		m_children->menuUpdateTimer.start();
 }
 
 void MainWindow::updateMenuItems()
@@ -525,7 +1740,145 @@ void MainWindow::updateMenuItems()
 	m_impl->actionPaste->setEnabled(textEdit != nullptr);
 	m_impl->actionDelete->setEnabled(hasSelect);
 	m_impl->actionSelectAll->setEnabled(hasText());
-	m_impl->actionRemoveNote->setEnabled(m_notes->selectedNote != NoteSet::iterator());
+	m_impl->actionRemoveNote->setEnabled(m_notes->selectedNote != NoteSet::iterator() &&
+		!m_notes->populating);
+
+	// The key isn't known until the file being opened is fully loaded.
+	bool locked = m_notes->locked;
+	bool opening = isOpening();
+	m_impl->actionSave->setEnabled(!locked && !opening);
+	m_impl->actionSaveAs->setEnabled(!locked && !opening);
+	m_impl->actionAddNote->setEnabled(!locked && !m_notes->populating);
+	m_impl->actionAddFolder->setEnabled(!locked && !m_notes->populating);
+	m_impl->addButton->setEnabled(!m_notes->populating);
+	m_impl->addFolderButton->setEnabled(!m_notes->populating);
+	m_impl->actionLock->setEnabled(locked || canLock());
+	m_impl->actionLock->setText(locked ? "&Unlock..." : "&Lock");
+}
+
+void MainWindow::notesChanged(NoteSet& notes, const std::vector<NoteChange>& changes)
+{
+	bool ignoreSelectionChanges = m_ignoreSelectionChanges;
+	m_ignoreSelectionChanges = true;
+
+	// The list rows need to be up to date before restoring the selection.
+	m_children->noteTreeModel.notesChanged(notes, changes);
+	m_children->noteVocabulary.notesChanged(notes, changes);
+	m_children->autoSaver.notesChanged(notes, changes);
+
+	bool modified = false;
+	bool positionsChanged = false;
+	bool reset = false;
+	std::vector<uint64_t> staleIds;
+	for (const NoteChange& change : changes)
+	{
+		switch (change.type)
+		{
+			case NoteChange::Type::Inserted:
+				modified = true;
+				positionsChanged = true;
+				m_notes->modifiedIds.insert(change.id);
+				break;
+			case NoteChange::Type::Removed:
+				modified = true;
+				positionsChanged = true;
+				staleIds.push_back(change.id);
+				m_notes->modifiedIds.insert(change.id);
+				break;
+			case NoteChange::Type::TitleChanged:
+			case NoteChange::Type::ParentChanged:
+				// The tree keeps each folder sorted, which can move the note to another row.
+				modified = true;
+				positionsChanged = true;
+				m_notes->modifiedIds.insert(change.id);
+				break;
+			case NoteChange::Type::MessageChanged:
+				// Changes to the selected note come from its document, while any other cached
+				// documents are now out of date.
+				modified = true;
+				m_notes->modifiedIds.insert(change.id);
+				if (change.id != m_notes->selectedNoteId)
+					staleIds.push_back(change.id);
+				break;
+			case NoteChange::Type::Moved:
+			case NoteChange::Type::Reordered:
+				positionsChanged = true;
+				break;
+			case NoteChange::Type::Reset:
+				positionsChanged = true;
+				reset = true;
+				break;
+		}
+	}
+
+	// Notes added while opening a file match it.
+	if (m_notes->populating)
+	{
+		modified = false;
+		m_notes->modifiedIds.clear();
+	}
+
+	bool selectionRemoved = false;
+	if (positionsChanged && m_notes->selectedNoteId != NoteChange::cNoId)
+	{
+		m_notes->selectedNote = notes.find(m_notes->selectedNoteId);
+		if (m_notes->selectedNote == notes.end())
+			selectionRemoved = true;
+		else
+		{
+			// Moved rows keep their selection, so only restore it when the rows were reset.
+			if (m_children->noteTreeModel.getNoteId(m_impl->noteList->currentIndex()) !=
+				m_notes->selectedNoteId)
+			{
+				selectNote(m_notes->selectedNoteId);
+			}
+		}
+	}
+
+	m_ignoreSelectionChanges = ignoreSelectionChanges;
+
+	// Fall back to whatever the list selected in place of the removed note.
+	if (selectionRemoved)
+	{
+		m_notes->selectedNote = NoteSet::iterator();
+		m_notes->selectedNoteId = NoteChange::cNoId;
+		onNoteSelectionChanged();
+	}
+
+	// Discard documents once the editor has moved off of any removed notes.
+	if (reset)
+	{
+		cancelNoteLoad();
+		setNoteDocument(nullptr);
+		m_children->documentCache.clear();
+	}
+	else
+	{
+		for (uint64_t id : staleIds)
+			discardNoteDocument(id);
+	}
+
+	// Changes merged from the file on disk set the modified state themselves.
+	if (modified && !m_notes->reloading)
+		markDirty();
+}
+
+bool MainWindow::eventFilter(QObject* watched, QEvent* event)
+{
+	switch (event->type())
+	{
+		case QEvent::KeyPress:
+		case QEvent::MouseButtonPress:
+		case QEvent::MouseMove:
+		case QEvent::Wheel:
+			if (m_lockIdleTime > 0 && !m_notes->locked)
+				m_children->lockTimer.start();
+			break;
+		default:
+			break;
+	}
+
+	return QMainWindow::eventFilter(watched, event);
 }
 
 void MainWindow::closeEvent(QCloseEvent* event)
@@ -541,10 +1894,11 @@ bool MainWindow::canClose()
 	if (!m_notes->dirty)
 		return true;
 
-	switch (m_children->confirmCloseDialog.show())
+	switch (m_children->getConfirmCloseDialog().show())
 	{
 		case ConfirmCloseDialog::Result::Save:
-			return save();
+			// The notes can only be saved once they're decrypted again.
+			return unlock() && save();
 		case ConfirmCloseDialog::Result::Cancel:
 			return false;
 		case ConfirmCloseDialog::Result::DontSave:
@@ -557,23 +1911,98 @@ bool MainWindow::canClose()
 
 void MainWindow::clear()
 {
-	m_notes.reset(new NoteContext);
+	m_notes.reset(new NoteContext(*this));
 	m_children->undoStack.clear();
+	m_children->autoSaver.reset();
+	cancelReload();
+	watchFile();
 	updateUi();
 	updateTitle();
+	updateLockState();
 }
 
-void MainWindow::updateUi()
+void MainWindow::cancelOpen()
 {
-	m_impl->noteList->clear();
-	for (const Note& note : m_notes->noteSet)
+	// Drop a file that's still being opened so it doesn't replace the new notes once loaded.
+	std::shared_ptr<OpenTask> task = std::move(m_children->openTask);
+	if (!task)
+		return;
+
+	task->promise.future().cancel();
+	m_children->openWatcher.setFuture(QFuture<NoteBatch>());
+	statusBar()->clearMessage();
+	m_children->openProgress->setVisible(false);
+	scheduleMenuUpdate();
+
+	// Notes already shown are only part of the file.
+	if (task->populated)
+		clear();
+}
+
+void MainWindow::cancelReload()
+{
+	std::shared_ptr<ReloadTask> task = std::move(m_children->reloadTask);
+	if (!task)
+		return;
+
+	task->promise.future().cancel();
+	m_children->reloadWatcher.setFuture(QFuture<void>());
+}
+
+void MainWindow::populateNotes()
+{
+	OpenTask& task = *m_children->openTask;
+	QFuture<NoteBatch> future = task.promise.future();
+	int batchCount = future.resultCount();
+
+	// The previous notes are replaced once the first batch arrives, which is after the password
+	// was verified. Files without any notes are set up once loading finishes.
+	if (!task.populated)
+	{
+		if (batchCount == 0 && !future.isFinished())
+			return;
+
+		QFileInfo fileInfo(task.filePath.c_str());
+		std::string fileName = fileInfo.fileName().toStdString();
+		size_t extensionPos = fileName.find_last_of('.');
+		if (extensionPos != std::string::npos)
+			fileName = fileName.substr(0, extensionPos);
+
+		clear();
+		m_notes->noteSet.setStorageMode(NoteSet::StorageMode::Arena);
+		m_notes->savePath = task.filePath;
+		m_notes->fileName = std::move(fileName);
+		m_notes->populating = true;
+		m_children->noteTreeModel.setEditable(false);
+		m_impl->noteText->setReadOnly(true);
+		updateTitle();
+		scheduleMenuUpdate();
+		task.populated = true;
+	}
+
+	// Each batch is sorted on the worker thread, so it only needs to be merged into the list.
+	for (; task.batchCount < batchCount; ++task.batchCount)
 	{
-		QListWidgetItem* newItem = new QListWidgetItem(note.getTitle().c_str());
-		newItem->setFlags(newItem->flags() | Qt::ItemIsEditable);
-		m_impl->noteList->insertItem(m_impl->noteList->count(), newItem);
+		NoteBatch batch = future.resultAt(task.batchCount);
+		m_notes->noteSet.insertSorted(*batch, compareTitles);
 	}
+}
+
+void MainWindow::updateUi()
+{
+	bool ignoreSelectionChanges = m_ignoreSelectionChanges;
+	m_ignoreSelectionChanges = true;
+	m_children->noteTreeModel.setNoteSet(&m_notes->noteSet);
+	m_ignoreSelectionChanges = ignoreSelectionChanges;
+
+	// Locking replaces the notes with an empty set, which also clears the vocabulary. The
+	// completions shown from the old vocabulary are cleared along with it.
+	m_children->noteVocabulary.build(m_notes->noteSet);
+	m_children->noteCompleter->clear();
+	m_children->autoSaver.notesReplaced();
 
 	updateForDeselection();
+	m_children->documentCache.clear();
 }
 
 void MainWindow::updateTitle()
@@ -591,52 +2020,174 @@ void MainWindow::updateTitle()
 	setWindowModified(m_notes->dirty);
 }
 
+void MainWindow::watchFile()
+{
+	QStringList files = m_children->fileWatcher.files();
+	if (!files.isEmpty())
+		m_children->fileWatcher.removePaths(files);
+
+	if (m_notes->savePath.empty())
+		return;
+
+	m_children->fileWatcher.addPath(QString::fromStdString(m_notes->savePath));
+	updateFileStamp();
+}
+
+void MainWindow::updateFileStamp()
+{
+	QFileInfo fileInfo(QString::fromStdString(m_notes->savePath));
+	m_notes->fileSize = fileInfo.size();
+	m_notes->fileModified = fileInfo.lastModified();
+}
+
+bool MainWindow::isFileStampCurrent() const
+{
+	if (m_notes->savePath.empty() || !m_notes->fileModified.isValid())
+		return true;
+
+	QFileInfo fileInfo(QString::fromStdString(m_notes->savePath));
+	return !fileInfo.exists() || (fileInfo.size() == m_notes->fileSize &&
+		fileInfo.lastModified() == m_notes->fileModified);
+}
+
+void MainWindow::updateFileHashes()
+{
+	// Only the notes changed since the file was last loaded or saved need to be hashed again.
+	std::unordered_set<uint64_t>& modifiedIds = m_notes->modifiedIds;
+	modifiedIds.insert(m_notes->autoSavingIds.begin(), m_notes->autoSavingIds.end());
+	for (uint64_t id : modifiedIds)
+	{
+		if (const Note* note = m_notes->noteSet.find_note(id))
+			m_notes->fileNoteHashes[id] = NoteHash::hash(*note);
+		else
+			m_notes->fileNoteHashes.erase(id);
+	}
+
+	modifiedIds.clear();
+	m_notes->autoSavingIds.clear();
+}
+
+void MainWindow::updateLockState()
+{
+	bool locked = m_notes->locked;
+	m_impl->splitter->setVisible(!locked);
+	m_impl->unlockButton->setVisible(locked);
+	if (locked)
+		m_children->lockTimer.stop();
+	else if (m_lockIdleTime > 0)
+		m_children->lockTimer.start();
+
+	scheduleMenuUpdate();
+}
+
 void MainWindow::markDirty()
 {
 	m_notes->dirty = true;
 	updateTitle();
+	m_children->compactTimer.start();
+	m_children->autoSaver.notesModified();
 }
 
-void MainWindow::sortNotes()
+void MainWindow::addNote(bool folder)
 {
-	m_ignoreSelectionChanges = true;
-
-	const uint64_t cNotSelected = (uint64_t)-1;
-	uint64_t selectedNoteId = cNotSelected;
-	if (m_notes->selectedNote != NoteSet::iterator())
-		selectedNoteId = m_notes->selectedNote->getId();
-	m_notes->noteSet.sort([] (const Note& left, const Note& right) -> bool
-		{
-			return strcasecmp(left.getTitle().c_str(), right.getTitle().c_str()) < 0;
-		});
+	Note newNote = m_notes->noteSet.createNote();
+	newNote.setTitle(folder ? "New folder" : "New note");
+	newNote.setParentId(getCurrentFolder());
+	newNote.setFolder(folder);
+	uint64_t id = newNote.getId();
+	pushCommand(new AddCommand(*this, std::move(newNote)));
+
+	m_impl->noteList->edit(m_children->noteTreeModel.indexOf(id));
+}
 
-	if (selectedNoteId != cNotSelected)
-		m_notes->selectedNote = m_notes->noteSet.find(selectedNoteId);
+uint64_t MainWindow::getCurrentFolder() const
+{
+	// New notes go into the selected folder, or next to the selected note.
+	if (m_notes->selectedNote == NoteSet::iterator())
+		return Note::cNoParent;
+	else if (m_notes->selectedNote->isFolder())
+		return m_notes->selectedNoteId;
+	return m_notes->selectedNote->getParentId();
+}
 
-	updateUi();
+void MainWindow::rootUnrootedNotes()
+{
+	// Notes whose folder is missing, such as when it was removed by another program, are moved
+	// to the top level so they stay visible.
+	std::vector<uint64_t> ids;
+	NoteTree::findUnrooted(ids, m_notes->noteSet);
+	if (ids.empty())
+		return;
 
-	if (selectedNoteId != cNotSelected)
-	{
-		m_impl->noteList->setCurrentRow(
-			static_cast<int>(m_notes->selectedNote - m_notes->noteSet.begin()));
-	}
+	std::vector<std::pair<uint64_t, uint64_t>> parents;
+	parents.reserve(ids.size());
+	for (uint64_t id : ids)
+		parents.emplace_back(id, Note::cNoParent);
+	m_notes->noteSet.setParents(parents);
+}
 
-	m_ignoreSelectionChanges = false;
+void MainWindow::selectNote(uint64_t id)
+{
+	m_impl->noteList->setCurrentIndex(m_children->noteTreeModel.indexOf(id));
 }
 
-void MainWindow::updateForSelection(ptrdiff_t item)
+void MainWindow::updateForSelection(uint64_t id)
 {
-	if (m_ignoreSelectionChanges || (size_t)item >= m_notes->noteSet.size())
+	if (m_ignoreSelectionChanges)
+		return;
+
+	NoteSet::iterator foundIter = m_notes->noteSet.find(id);
+	if (foundIter == m_notes->noteSet.end())
 		return;
 
 	m_ignoreSelectionChanges = true;
-	m_notes->selectedNote = m_notes->noteSet.begin() + item;
-	m_impl->removeButton->setEnabled(true);
-	m_impl->actionRemoveNote->setEnabled(true);
+	m_notes->selectedNote = foundIter;
+	m_notes->selectedNoteId = id;
+	if (m_children->loadingNoteId != m_notes->selectedNoteId)
+		cancelNoteLoad();
+	m_impl->removeButton->setEnabled(!m_notes->populating);
+	m_impl->actionRemoveNote->setEnabled(!m_notes->populating);
+
+	// Folders only hold other notes, so there's nothing to edit.
+	if (foundIter->isFolder())
+	{
+		m_impl->noteText->setEnabled(false);
+		setNoteDocument(nullptr);
+		m_ignoreSelectionChanges = false;
+		scheduleMenuUpdate();
+		return;
+	}
+
 	m_impl->noteText->setEnabled(true);
-	m_impl->noteText->setPlainText(m_notes->selectedNote->getMessage().c_str());
-	m_impl->noteText->document()->clearUndoRedoStacks();
+
+	// Recently used notes keep their document, including the layout and undo history.
+	bool created = false;
+	QTextDocument* document = m_children->documentCache.acquire(m_notes->selectedNoteId, created);
+	if (created)
+	{
+		document->setDefaultFont(m_impl->noteText->font());
+
+		// The highlighter is attached before adding the text so large notes are highlighted as
+		// they're loaded, starting with the part that's shown first.
+		new NoteHighlighter(document);
+		if (m_notes->selectedNote->getMessage().size() > cLargeNoteSize)
+			startNoteLoad(*document);
+		else
+		{
+			document->setPlainText(toQString(m_notes->selectedNote->getMessage()));
+			document->clearUndoRedoStacks();
+		}
+	}
+	setNoteDocument(document);
+
+	// Other documents may have grown since they were last used, so check the budget whenever one
+	// is shown. This waits until the editor has switched so the previous document isn't evicted
+	// while it's still in use.
+	m_children->documentCache.trim();
+	m_impl->noteText->setReadOnly(m_children->loadingNoteId == m_notes->selectedNoteId ||
+		m_notes->populating);
 	m_ignoreSelectionChanges = false;
+	scheduleMenuUpdate();
 }
 
 void MainWindow::updateForDeselection()
@@ -645,25 +2196,184 @@ void MainWindow::updateForDeselection()
 		return;
 
 	m_ignoreSelectionChanges = true;
+	cancelNoteLoad();
 	m_notes->selectedNote = NoteSet::iterator();
+	m_notes->selectedNoteId = NoteChange::cNoId;
 	m_impl->removeButton->setEnabled(false);
 	m_impl->actionRemoveNote->setEnabled(false);
 	m_impl->noteText->setEnabled(false);
-	m_impl->noteText->clear();
+	setNoteDocument(nullptr);
 	m_ignoreSelectionChanges = false;
+	scheduleMenuUpdate();
+}
+
+void MainWindow::setNoteDocument(QTextDocument* document)
+{
+	// A null document gives the editor a new empty document of its own. Its previous document is
+	// deleted if it owned it, so disconnect before switching.
+	QObject::disconnect(m_impl->noteText->document(), SIGNAL(contentsChange(int, int, int)), this,
+		SLOT(onNoteTextChanged(int, int, int)));
+	m_impl->noteText->setDocument(document);
+	QObject::connect(m_impl->noteText->document(), SIGNAL(contentsChange(int, int, int)), this,
+		SLOT(onNoteTextChanged(int, int, int)));
+	m_children->markdownPreview.setSourceDocument(m_impl->noteText->document());
+}
+
+void MainWindow::discardNoteDocument(uint64_t id)
+{
+	if (id == m_children->loadingNoteId)
+	{
+		cancelNoteLoad();
+		return;
+	}
+
+	QTextDocument* document = m_children->documentCache.find(id);
+	if (!document)
+		return;
+
+	if (document == m_impl->noteText->document())
+		setNoteDocument(nullptr);
+	m_children->documentCache.remove(id);
+}
+
+void MainWindow::startNoteLoad(QTextDocument& document)
+{
+	// The note stays read-only until it's fully loaded, and loading isn't part of the undo history.
+	document.setUndoRedoEnabled(false);
+	m_children->loadingNoteId = m_notes->selectedNoteId;
+	m_children->loadOffset = 0;
+
+	// Load the first chunk immediately so the start of the note is shown right away.
+	if (loadNoteChunk(document, m_notes->selectedNote->getMessage()))
+		finishNoteLoad(document);
+	else
+		m_children->loadTimer.start();
+}
+
+bool MainWindow::loadNoteChunk(QTextDocument& document, const NoteBody& message)
+{
+	size_t offset = m_children->loadOffset;
+	size_t end = std::min(offset + cLoadChunkSize, message.size());
+	while (end > offset && end < message.size() &&
+		(static_cast<unsigned char>(message.at(end)) & 0xC0) == 0x80)
+	{
+		--end;
+	}
+
+	std::string chunk = message.substr(offset, end - offset);
+	QTextCursor cursor(&document);
+	cursor.movePosition(QTextCursor::End);
+	cursor.insertText(QString::fromUtf8(chunk.data(), static_cast<qsizetype>(chunk.size())));
+
+	m_children->loadOffset = end;
+	return end == message.size();
+}
+
+void MainWindow::finishNoteLoad(QTextDocument& document)
+{
+	document.setUndoRedoEnabled(true);
+	m_children->loadingNoteId = NoteChange::cNoId;
+	m_children->loadTimer.stop();
+	m_impl->noteText->setReadOnly(m_notes->populating);
+	scheduleMenuUpdate();
+}
+
+void MainWindow::cancelNoteLoad()
+{
+	uint64_t id = m_children->loadingNoteId;
+	if (id == NoteChange::cNoId)
+		return;
+
+	m_children->loadingNoteId = NoteChange::cNoId;
+	m_children->loadTimer.stop();
+	m_impl->noteText->setReadOnly(m_notes->populating);
+
+	// A partially loaded document can't be reused.
+	discardNoteDocument(id);
+}
+
+void MainWindow::pushCommand(QUndoCommand* command)
+{
+	// The size of the command is counted and the history trimmed once the index changes.
+	m_children->undoStack.push(command);
+}
+
+void MainWindow::onUndoIndexChanged(int index)
+{
+	// Only the commands that were just pushed, undone, or redone changed size. Commands past the
+	// end of the stack were deleted by a push or clear, and already left the total.
+	int first = std::min(index, m_children->undoIndex);
+	int last = std::min(std::max(index, m_children->undoIndex), m_children->undoStack.count());
+	for (int i = first; i < last; ++i)
+		getHistoryCommand(i)->countSize(m_children->undoHistorySize);
+	m_children->undoIndex = index;
+
+	trimUndoHistory();
 }
 
-void MainWindow::updateCommands(const Note& note)
+void MainWindow::trimUndoHistory()
 {
-	for (int i = 0; i < m_children->undoStack.count(); ++i)
+	if (m_children->undoHistorySize <= m_undoMemoryBudget)
+		return;
+
+	// Trim the oldest commands first, then the furthest redo commands. The most recent command is
+	// always kept so the last change can be undone. Trimmed commands stay contiguous at either end
+	// of the stack, so only the commands next to the current index need to be checked to see if
+	// undo or redo is available, and the ones already trimmed are skipped with a binary search.
+	const QUndoStack& undoStack = m_children->undoStack;
+	int lastUndoIndex = undoStack.index() - 1;
+	int begin = 0;
+	int end = std::max(lastUndoIndex, 0);
+	while (begin < end)
+	{
+		int middle = begin + (end - begin)/2;
+		if (getHistoryCommand(middle)->isTrimmed())
+			begin = middle + 1;
+		else
+			end = middle;
+	}
+
+	for (int i = begin; i < lastUndoIndex && m_children->undoHistorySize > m_undoMemoryBudget; ++i)
+		getHistoryCommand(i)->trim();
+
+	begin = lastUndoIndex + 1;
+	end = undoStack.count();
+	while (begin < end)
+	{
+		int middle = begin + (end - begin)/2;
+		if (getHistoryCommand(middle)->isTrimmed())
+			end = middle;
+		else
+			begin = middle + 1;
+	}
+
+	for (int i = begin - 1; i > lastUndoIndex && m_children->undoHistorySize > m_undoMemoryBudget;
+		--i)
 	{
-		const NoteCommand* noteCommand =
-				dynamic_cast<const NoteCommand*>(m_children->undoStack.command(i));
-		if (noteCommand)
-			noteCommand->updateNote(note);
+		getHistoryCommand(i)->trim();
 	}
 }
 
+MainWindow::HistoryCommand* MainWindow::getHistoryCommand(int index) const
+{
+	return const_cast<HistoryCommand*>(
+		static_cast<const HistoryCommand*>(m_children->undoStack.command(index)));
+}
+
+bool MainWindow::canUndoNotes() const
+{
+	const QUndoStack& undoStack = m_children->undoStack;
+	return undoStack.canUndo() && !static_cast<const HistoryCommand*>(
+		undoStack.command(undoStack.index() - 1))->isTrimmed();
+}
+
+bool MainWindow::canRedoNotes() const
+{
+	const QUndoStack& undoStack = m_children->undoStack;
+	return undoStack.canRedo() && !static_cast<const HistoryCommand*>(
+		undoStack.command(undoStack.index()))->isTrimmed();
+}
+
 QObject* MainWindow::getCurrentUndoStack()
 {
 	QWidget* focus = focusWidget();
@@ -701,7 +2411,7 @@ bool MainWindow::hasText() const
 {
 	QWidget* focus = focusWidget();
 	if (QPlainTextEdit* plainText = dynamic_cast<QPlainTextEdit*>(focus))
-		return !plainText->toPlainText().isEmpty();
+		return !plainText->document()->isEmpty();
 	else if (QLineEdit* lineEdit = dynamic_cast<QLineEdit*>(focus))
 		return !lineEdit->text().isEmpty();
 	else
@@ -716,7 +2426,7 @@ bool MainWindow::canUndo() const
 	else if (QLineEdit* lineEdit = dynamic_cast<QLineEdit*>(focus))
 		return lineEdit->isUndoAvailable();
 	else
-		return m_children->undoStack.canUndo();
+		return canUndoNotes();
 }
 
 bool MainWindow::canRedo() const
@@ -727,7 +2437,7 @@ bool MainWindow::canRedo() const
 	else if (QLineEdit* lineEdit = dynamic_cast<QLineEdit*>(focus))
 		return lineEdit->isRedoAvailable();
 	else
-		return m_children->undoStack.canRedo();
+		return canRedoNotes();
 }
 
 QString MainWindow::getUndoText() const
@@ -749,7 +2459,7 @@ QString MainWindow::getUndoText() const
 	}
 	else
 	{
-		if (m_children->undoStack.canUndo())
+		if (canUndoNotes())
 			return "&Undo " + m_children->undoStack.undoText();
 		else
 			return "&Undo";
@@ -775,7 +2485,7 @@ QString MainWindow::getRedoText() const
 	}
 	else
 	{
-		if (m_children->undoStack.canRedo())
+		if (canRedoNotes())
 			return "&Redo " + m_children->undoStack.redoText();
 		else
 			return "&Redo";
@@ -787,35 +2497,51 @@ bool MainWindow::save()
 	if (m_notes->savePath.empty())
 		return saveAs();
 
-	FileOStream stream;
+	if (!isFileStampCurrent() && QMessageBox::question(this, "Notes Changed on Disk",
+			"The notes file was changed by another program. Overwrite those changes?") !=
+		QMessageBox::Yes)
+	{
+		return false;
+	}
+
+	// Don't write the file at the same time as an autosave.
+	m_children->autoSaver.waitForSave();
+
+	SaveFileOStream stream;
 	if (!stream.open(m_notes->savePath) || NoteFile::saveNotes(m_notes->noteSet, stream,
-		m_notes->salt, m_notes->key) != NoteFile::Result::Success)
+		m_notes->salt, m_notes->key) != NoteFile::Result::Success || !stream.commit())
 	{
 		QMessageBox::warning(this, "Couldn't Save", "Error saving file");
 		return false;
 	}
 
+	m_children->autoSaver.reset();
 	m_notes->dirty = false;
+	updateFileHashes();
+	watchFile();
 	updateTitle();
+	scheduleMenuUpdate();
 	return true;
 }
 
 bool MainWindow::saveAs()
 {
-	m_children->fileDialog.setAcceptMode(QFileDialog::AcceptSave);
-	m_children->fileDialog.setFileMode(QFileDialog::AnyFile);
-	m_children->fileDialog.setWindowTitle("Save Notes");
+	QFileDialog& fileDialog = m_children->getFileDialog();
+	fileDialog.setAcceptMode(QFileDialog::AcceptSave);
+	fileDialog.setFileMode(QFileDialog::AnyFile);
+	fileDialog.setWindowTitle("Save Notes");
 
-	if (!m_children->fileDialog.exec())
+	if (!fileDialog.exec())
 		return false;
 
-	if (!m_children->savePasswordDialog.exec())
+	SavePasswordDialog& savePasswordDialog = m_children->getSavePasswordDialog();
+	if (!savePasswordDialog.exec())
 		return false;
 
-	std::string password = m_children->savePasswordDialog.getPassword();
+	std::string password = savePasswordDialog.getPassword();
 	assert(!password.empty());
 
-	QStringList selectedFile = m_children->fileDialog.selectedFiles();
+	QStringList selectedFile = fileDialog.selectedFiles();
 	QFileInfo fileInfo(selectedFile[0]);
 
 	m_notes->savePath = fileInfo.absoluteFilePath().toStdString();
@@ -824,6 +2550,13 @@ bool MainWindow::saveAs()
 	if (extensionPos != std::string::npos)
 		m_notes->fileName = m_notes->fileName.substr(0, extensionPos);
 
+	// Everything is new to the file being saved to.
+	m_notes->fileNoteHashes.clear();
+	m_notes->autoSavingIds.clear();
+	for (const Note& note : m_notes->noteSet)
+		m_notes->modifiedIds.insert(note.getId());
+	m_notes->fileModified = QDateTime();
+
 	m_notes->salt = Crypto::random(Crypto::cSaltLenBytes);
 	m_notes->key = Crypto::generateKey(password, m_notes->salt, Crypto::cDefaultKeyIterations);
 	return save();
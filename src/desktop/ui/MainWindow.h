@@ -1,6 +1,6 @@
 #pragma once
 /*
- * Copyright 2015 Aaron Barany
+ * Copyright 2015-2026 Aaron Barany
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -15,6 +15,7 @@
  * limitations under the License.
  */
 
+#include "notes/NoteSetListener.h"
 #include <QtWidgets/QMainWindow>
 #include <memory>
 
@@ -23,23 +24,56 @@ namespace Ui
 	class MainWindow;
 }
 
-class QListWidgetItem;
+class QTextDocument;
+class QUndoCommand;
+class QUrl;
 class QUndoStack;
 
 namespace NoteVault
 {
 
 class Note;
+class NoteBody;
 
-class MainWindow : public QMainWindow
+class MainWindow : public QMainWindow, private NoteSetListener
 {
 	Q_OBJECT
 public:
 	MainWindow();
 	~MainWindow();
 
+	// Asks for the password, then loads the file in the background. Notes are shown as they're
+	// decrypted, and are read-only until the whole file is loaded. Returns false if the file
+	// couldn't be read or the password prompt was canceled. openFinished() is emitted once the
+	// file is loaded or opening fails.
 	bool open(const std::string& fileName);
 
+	// Returns true if the file is open or being opened.
+	bool hasFile(const std::string& filePath) const;
+	bool isOpening() const;
+
+	// Returns true if no notes have been opened or added, so a file can be opened in its place.
+	bool isUnused() const;
+
+	size_t getUndoMemoryBudget() const	{return m_undoMemoryBudget;}
+	void setUndoMemoryBudget(size_t bytes);
+
+	// Locking keeps the notes only as an encrypted image in memory, wiping the key and the
+	// decrypted notes until the password is entered again. Notes that have never been saved
+	// can't be locked since they don't have a password yet.
+	bool isLocked() const;
+	bool canLock() const;
+	bool lock();
+	bool unlock();
+
+	// The notes are locked after this long without input. An interval of 0 disables locking
+	// when idle.
+	int getLockIdleTime() const	{return m_lockIdleTime;}
+	void setLockIdleTime(int ms);
+
+Q_SIGNALS:
+	void openFinished(bool success);
+
 private Q_SLOTS:
 	void onNew();
 	void onOpen();
@@ -53,32 +87,72 @@ private Q_SLOTS:
 	void onDelete();
 	void onSelectAll();
 	void onAddNote();
+	void onAddFolder();
 	void onRemoveNote();
 	void onPasswordGenerator();
 	void onAbout();
+	void onLock();
 
-	void onNoteRenamed(QListWidgetItem* item);
+	void onNoteRenamed(quint64 id, const QString& title);
+	void onNotesDropped(const QList<quint64>& ids, quint64 folderId);
 	void onNoteSelectionChanged();
-
-	void onNoteTextChanged();
-
+	void onShowPreview(bool show);
+	void onPreviewLinkClicked(const QUrl& url);
+
+	void onNoteTextChanged(int position, int charsRemoved, int charsAdded);
+	void onCompactNotes();
+	void onLoadNoteChunk();
+	void onOpenNotesReady(int beginIndex, int endIndex);
+	void onOpenFinished();
+	void onFileChanged();
+	void onCheckFile();
+	void onReloadFinished();
+	void onAutoSave();
+	void onAutoSaved(bool upToDate);
+	void onAutoSaveFailed();
+	void onLockIdle();
+	void onFocusChanged(QWidget* oldWidget, QWidget* newWidget);
+	void onUndoIndexChanged(int index);
+
+	void scheduleMenuUpdate();
 	void updateMenuItems();
 
 private:
 	MainWindow(const MainWindow&) = delete;
 	MainWindow& operator=(const MainWindow&) = delete;
 
+	void notesChanged(NoteSet& notes, const std::vector<NoteChange>& changes) override;
+	bool eventFilter(QObject* watched, QEvent* event) override;
 	void closeEvent(QCloseEvent* event) override;
 
 	bool canClose();
 	void clear();
+	void cancelOpen();
+	void cancelReload();
+	void populateNotes();
 	void updateUi();
 	void updateTitle();
+	void updateLockState();
+	void watchFile();
+	void updateFileStamp();
+	bool isFileStampCurrent() const;
+	void updateFileHashes();
 	void markDirty();
-	void sortNotes();
-	void updateForSelection(ptrdiff_t item);
+	void addNote(bool folder);
+	uint64_t getCurrentFolder() const;
+	void rootUnrootedNotes();
+	void selectNote(uint64_t id);
+	void updateForSelection(uint64_t id);
 	void updateForDeselection();
-	void updateCommands(const Note& note);
+	void setNoteDocument(QTextDocument* document);
+	void discardNoteDocument(uint64_t id);
+	void startNoteLoad(QTextDocument& document);
+	bool loadNoteChunk(QTextDocument& document, const NoteBody& message);
+	void finishNoteLoad(QTextDocument& document);
+	void cancelNoteLoad();
+	void pushCommand(QUndoCommand* command);
+	void trimUndoHistory();
+	HistoryCommand* getHistoryCommand(int index) const;
 
 	QObject* getCurrentUndoStack();
 	QObject* getCurrentTextEdit();
@@ -87,6 +161,8 @@ private:
 	bool hasText() const;
 	bool canUndo() const;
 	bool canRedo() const;
+	bool canUndoNotes() const;
+	bool canRedoNotes() const;
 	QString getUndoText() const;
 	QString getRedoText() const;
 
@@ -95,16 +171,23 @@ private:
 
 	struct ChildItems;
 	struct NoteContext;
+	struct OpenTask;
+	struct ReloadTask;
+	class HistoryCommand;
 	class NoteCommand;
 	class AddCommand;
 	class RemoveCommand;
+	class RemoveNotesCommand;
 	class RenameCommand;
+	class MoveCommand;
 
 	std::unique_ptr<Ui::MainWindow> m_impl;
 	std::unique_ptr<ChildItems> m_children;
 	std::unique_ptr<NoteContext> m_notes;
 
 	bool m_ignoreSelectionChanges;
+	size_t m_undoMemoryBudget;
+	int m_lockIdleTime;
 };
 
 } // namespace NoteVault
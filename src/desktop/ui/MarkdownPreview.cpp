@@ -0,0 +1,591 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MarkdownPreview.h"
+
+#include <QtCore/QStringList>
+#include <QtCore/QStringView>
+#include <QtGui/QFontDatabase>
+#include <QtGui/QFontInfo>
+#include <QtGui/QGuiApplication>
+#include <QtGui/QPalette>
+#include <QtGui/QTextBlock>
+#include <QtGui/QTextCursor>
+#include <vector>
+
+#include "MarkdownPreview.moc"
+
+namespace NoteVault
+{
+
+// Longer lines, such as encoded keys, are shown as they are instead of looking for inline styles.
+static const int cMaxInlineLength = 4096;
+
+static const qreal cHeadingScales[6] = {1.8, 1.5, 1.3, 1.15, 1.0, 0.9};
+
+static bool isRule(QStringView line)
+{
+	if (line.isEmpty() || (line[0] != u'-' && line[0] != u'*' && line[0] != u'_'))
+		return false;
+
+	QChar marker = line[0];
+	int count = 0;
+	for (QChar c : line)
+	{
+		if (c == marker)
+			++count;
+		else if (c != u' ' && c != u'\t')
+			return false;
+	}
+	return count >= 3;
+}
+
+class MarkdownPreview::RenderedLine : public QTextBlockUserData
+{
+public:
+	enum class Type
+	{
+		Text,
+		Heading,
+		ListItem,
+		Quote,
+		Rule,
+		Fence,
+		Code
+	};
+
+	// Inline styles, which may be combined.
+	static const unsigned int cBold = 0x1;
+	static const unsigned int cItalic = 0x2;
+	static const unsigned int cCode = 0x4;
+	static const unsigned int cLink = 0x8;
+
+	struct Span
+	{
+		int start;
+		int length;
+		unsigned int style;
+		int link;
+	};
+
+	RenderedLine()
+		: revision(-1), length(-1), inFence(false), endsInFence(false), type(Type::Text),
+		level(0)
+	{
+	}
+
+	static RenderedLine* get(const QTextBlock& block)
+	{
+		return static_cast<RenderedLine*>(block.userData());
+	}
+
+	bool isCurrent(const QTextBlock& block, bool lineInFence) const
+	{
+		return revision == block.revision() && length == block.length() &&
+			inFence == lineInFence;
+	}
+
+	void parse(const QString& source, bool lineInFence);
+
+	// The source block this was rendered from.
+	int revision;
+	int length;
+	bool inFence;
+	bool endsInFence;
+
+	Type type;
+	int level;
+	QString text;
+	std::vector<Span> spans;
+	QStringList links;
+
+private:
+	void appendInline(QStringView source);
+	void appendText(QStringView part, unsigned int style, int link = -1);
+};
+
+void MarkdownPreview::RenderedLine::parse(const QString& source, bool lineInFence)
+{
+	inFence = lineInFence;
+	endsInFence = lineInFence;
+	type = Type::Text;
+	level = 0;
+	text.clear();
+	spans.clear();
+	links.clear();
+
+	int indent = 0;
+	while (indent < source.size() && (source[indent] == u' ' || source[indent] == u'\t'))
+		++indent;
+	QStringView line = QStringView(source).mid(indent);
+
+	// Code is shown as it is until the fence is closed.
+	if (line.startsWith(u"```") || line.startsWith(u"~~~"))
+	{
+		type = Type::Fence;
+		endsInFence = !inFence;
+		return;
+	}
+	else if (inFence)
+	{
+		type = Type::Code;
+		text = source;
+		return;
+	}
+
+	int headingLevel = 0;
+	while (headingLevel < line.size() && headingLevel < 6 && line[headingLevel] == u'#')
+		++headingLevel;
+	if (headingLevel > 0 && (headingLevel == line.size() || line[headingLevel] == u' '))
+	{
+		type = Type::Heading;
+		level = headingLevel;
+		appendInline(line.mid(headingLevel).trimmed());
+		return;
+	}
+
+	if (isRule(line))
+	{
+		type = Type::Rule;
+		return;
+	}
+
+	// Nested list items are indented by a couple of spaces for each level.
+	if (line.size() >= 2 && (line[0] == u'-' || line[0] == u'*' || line[0] == u'+') &&
+		line[1] == u' ')
+	{
+		type = Type::ListItem;
+		level = indent/2;
+		text.append(QChar(0x2022));
+		text.append(u' ');
+		appendInline(line.mid(2));
+		return;
+	}
+
+	int digits = 0;
+	while (digits < line.size() && digits < 9 && line[digits] >= u'0' && line[digits] <= u'9')
+		++digits;
+	if (digits > 0 && digits + 1 < line.size() &&
+		(line[digits] == u'.' || line[digits] == u')') && line[digits + 1] == u' ')
+	{
+		type = Type::ListItem;
+		level = indent/2;
+		text.append(line.left(digits));
+		text.append(u". ");
+		appendInline(line.mid(digits + 2));
+		return;
+	}
+
+	if (!line.isEmpty() && line[0] == u'>')
+	{
+		type = Type::Quote;
+		line = line.mid(1);
+		if (!line.isEmpty() && line[0] == u' ')
+			line = line.mid(1);
+	}
+	appendInline(line);
+}
+
+void MarkdownPreview::RenderedLine::appendInline(QStringView source)
+{
+	if (source.size() > cMaxInlineLength)
+	{
+		appendText(source, 0);
+		return;
+	}
+
+	unsigned int style = 0;
+	int size = static_cast<int>(source.size());
+	int i = 0;
+	while (i < size)
+	{
+		QChar c = source[i];
+		if (c == u'\\' && i + 1 < size && source[i + 1].isPunct())
+		{
+			appendText(source.mid(i + 1, 1), style);
+			i += 2;
+			continue;
+		}
+		else if (c == u'`')
+		{
+			int end = static_cast<int>(source.indexOf(u'`', i + 1));
+			if (end > i + 1)
+			{
+				appendText(source.mid(i + 1, end - i - 1), style | cCode);
+				i = end + 1;
+				continue;
+			}
+		}
+		else if (c == u'[')
+		{
+			int textEnd = static_cast<int>(source.indexOf(u"](", i + 1));
+			int linkEnd = textEnd < 0 ? -1 : static_cast<int>(source.indexOf(u')', textEnd + 2));
+			if (linkEnd >= 0)
+			{
+				links.append(source.mid(textEnd + 2, linkEnd - textEnd - 2).trimmed().toString());
+				appendText(source.mid(i + 1, textEnd - i - 1), style | cLink,
+					static_cast<int>(links.size()) - 1);
+				i = linkEnd + 1;
+				continue;
+			}
+		}
+		else if (c == u'*' || c == u'_')
+		{
+			// Doubled markers are bold and single markers italic. A style is only started when
+			// it's closed later on the line, and underscores inside of words, such as in names,
+			// are left alone.
+			int markerLength = i + 1 < size && source[i + 1] == c ? 2 : 1;
+			unsigned int markerStyle = markerLength == 2 ? cBold : cItalic;
+			int after = i + markerLength;
+			bool wordBefore = i > 0 && source[i - 1].isLetterOrNumber();
+			bool wordAfter = after < size && source[after].isLetterOrNumber();
+			if (style & markerStyle)
+			{
+				if (!source[i - 1].isSpace() && (c == u'*' || !wordAfter))
+				{
+					style &= ~markerStyle;
+					i = after;
+					continue;
+				}
+			}
+			else if (after < size && !source[after].isSpace() && (c == u'*' || !wordBefore) &&
+				source.indexOf(source.mid(i, markerLength), after + 1) >= 0)
+			{
+				style |= markerStyle;
+				i = after;
+				continue;
+			}
+		}
+
+		appendText(source.mid(i, 1), style);
+		++i;
+	}
+}
+
+void MarkdownPreview::RenderedLine::appendText(QStringView part, unsigned int style, int link)
+{
+	if (part.isEmpty())
+		return;
+
+	int start = static_cast<int>(text.size());
+	int partLength = static_cast<int>(part.size());
+	text.append(part);
+	if (style == 0)
+		return;
+
+	if (!spans.empty())
+	{
+		Span& lastSpan = spans.back();
+		if (lastSpan.start + lastSpan.length == start && lastSpan.style == style &&
+			lastSpan.link == link)
+		{
+			lastSpan.length += partLength;
+			return;
+		}
+	}
+
+	Span span = {start, partLength, style, link};
+	spans.push_back(span);
+}
+
+MarkdownPreview::MarkdownPreview(QObject* parent)
+	: QObject(parent), m_enabled(false)
+{
+	m_document.setUndoRedoEnabled(false);
+	updateFormats();
+}
+
+MarkdownPreview::~MarkdownPreview()
+{
+}
+
+void MarkdownPreview::setSourceDocument(QTextDocument* source)
+{
+	if (m_source && m_enabled)
+	{
+		QObject::disconnect(m_source, SIGNAL(contentsChange(int, int, int)), this,
+			SLOT(onContentsChange(int, int, int)));
+	}
+
+	m_source = source;
+	if (m_source && m_enabled)
+	{
+		QObject::connect(m_source, SIGNAL(contentsChange(int, int, int)), this,
+			SLOT(onContentsChange(int, int, int)));
+	}
+	rebuild();
+}
+
+void MarkdownPreview::setEnabled(bool enabled)
+{
+	if (enabled == m_enabled)
+		return;
+
+	m_enabled = enabled;
+	if (m_source)
+	{
+		if (m_enabled)
+		{
+			QObject::connect(m_source, SIGNAL(contentsChange(int, int, int)), this,
+				SLOT(onContentsChange(int, int, int)));
+		}
+		else
+		{
+			QObject::disconnect(m_source, SIGNAL(contentsChange(int, int, int)), this,
+				SLOT(onContentsChange(int, int, int)));
+		}
+	}
+	rebuild();
+}
+
+void MarkdownPreview::setFont(const QFont& font)
+{
+	m_document.setDefaultFont(font);
+	updateFormats();
+	rebuild();
+}
+
+void MarkdownPreview::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+	if (!m_source)
+		return;
+
+	// The blocks from where the change starts to where it ends replace the same range of lines
+	// in the preview, offset by the number of lines that were added or removed.
+	QTextBlock first = m_source->findBlock(position);
+	QTextBlock last = m_source->findBlock(position + charsAdded);
+	if (!first.isValid())
+		first = m_source->lastBlock();
+	if (!last.isValid())
+		last = m_source->lastBlock();
+
+	int firstNumber = first.blockNumber();
+	int lastNumber = last.blockNumber();
+	int oldLastNumber = lastNumber - (m_source->blockCount() - m_document.blockCount());
+	if (oldLastNumber < firstNumber || oldLastNumber >= m_document.blockCount())
+	{
+		rebuild();
+		return;
+	}
+
+	bool inFence = false;
+	QTextBlock previous = first.previous();
+	if (previous.isValid())
+	{
+		const RenderedLine* line = RenderedLine::get(previous);
+		inFence = line && line->endsInFence;
+	}
+
+	// Formatting changes, such as from highlighting, report the same text as removed and added
+	// again, so there's nothing to do if the lines are still current.
+	bool force = charsRemoved != charsAdded || lastNumber != oldLastNumber;
+	if (!force)
+	{
+		bool current = true;
+		bool lineInFence = inFence;
+		for (QTextBlock block = first; ; block = block.next())
+		{
+			const RenderedLine* line = RenderedLine::get(block);
+			if (!line || !line->isCurrent(block, lineInFence))
+			{
+				current = false;
+				break;
+			}
+
+			lineInFence = line->endsInFence;
+			if (block == last)
+				break;
+		}
+
+		if (current)
+			return;
+	}
+
+	QTextCursor cursor(m_document.findBlockByNumber(firstNumber));
+	QTextBlock oldLast = m_document.findBlockByNumber(oldLastNumber);
+	cursor.beginEditBlock();
+	cursor.setPosition(oldLast.position() + oldLast.length() - 1, QTextCursor::KeepAnchor);
+	cursor.removeSelectedText();
+	for (QTextBlock block = first; ; block = block.next())
+	{
+		const RenderedLine& line = renderLine(block, inFence, force);
+		writeLine(cursor, line);
+		inFence = line.endsInFence;
+		if (block == last)
+			break;
+
+		cursor.insertBlock();
+	}
+
+	// Opening or closing a code fence changes the lines after it until reaching one that was
+	// already rendered with the same state.
+	QTextBlock previewBlock = cursor.block().next();
+	for (QTextBlock block = last.next(); block.isValid() && previewBlock.isValid();
+		block = block.next(), previewBlock = previewBlock.next())
+	{
+		const RenderedLine* cachedLine = RenderedLine::get(block);
+		if (cachedLine && cachedLine->isCurrent(block, inFence))
+			break;
+
+		const RenderedLine& line = renderLine(block, inFence, false);
+		replaceLine(previewBlock, line);
+		inFence = line.endsInFence;
+	}
+	cursor.endEditBlock();
+}
+
+void MarkdownPreview::rebuild()
+{
+	m_document.clear();
+	if (!m_enabled || !m_source)
+		return;
+
+	// Lines cached from when the note was last shown are reused.
+	QTextCursor cursor(&m_document);
+	cursor.beginEditBlock();
+	bool inFence = false;
+	for (QTextBlock block = m_source->begin(); block.isValid(); block = block.next())
+	{
+		if (block != m_source->begin())
+			cursor.insertBlock();
+
+		const RenderedLine& line = renderLine(block, inFence, false);
+		writeLine(cursor, line);
+		inFence = line.endsInFence;
+	}
+	cursor.endEditBlock();
+}
+
+void MarkdownPreview::updateFormats()
+{
+	QFont font = m_document.defaultFont();
+	qreal pointSize = font.pointSizeF();
+	if (pointSize <= 0)
+		pointSize = QFontInfo(font).pointSizeF();
+	QPalette palette = QGuiApplication::palette();
+
+	m_textFormat = QTextCharFormat();
+	for (int i = 0; i < 6; ++i)
+	{
+		m_headingFormats[i] = QTextCharFormat();
+		m_headingFormats[i].setFontWeight(QFont::Bold);
+		m_headingFormats[i].setFontPointSize(pointSize*cHeadingScales[i]);
+	}
+
+	m_quoteFormat = QTextCharFormat();
+	m_quoteFormat.setFontItalic(true);
+	m_quoteFormat.setForeground(palette.placeholderText());
+
+	QFont codeFont = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+	m_codeFormat = QTextCharFormat();
+	m_codeFormat.setFontFamilies(QStringList(codeFont.family()));
+	m_codeFormat.setFontFixedPitch(true);
+
+	m_linkFormat = QTextCharFormat();
+	m_linkFormat.setAnchor(true);
+	m_linkFormat.setFontUnderline(true);
+	m_linkFormat.setForeground(palette.link());
+
+	m_codeBackground = palette.alternateBase();
+}
+
+const MarkdownPreview::RenderedLine& MarkdownPreview::renderLine(QTextBlock block, bool inFence,
+	bool force)
+{
+	RenderedLine* line = RenderedLine::get(block);
+	if (!line)
+	{
+		line = new RenderedLine;
+		block.setUserData(line);
+	}
+	else if (!force && line->isCurrent(block, inFence))
+		return *line;
+
+	line->parse(block.text(), inFence);
+	line->revision = block.revision();
+	line->length = block.length();
+	return *line;
+}
+
+void MarkdownPreview::writeLine(QTextCursor& cursor, const RenderedLine& line) const
+{
+	QTextBlockFormat blockFormat;
+	QTextCharFormat format = m_textFormat;
+	switch (line.type)
+	{
+		case RenderedLine::Type::Text:
+			break;
+		case RenderedLine::Type::Heading:
+			blockFormat.setHeadingLevel(line.level);
+			format = m_headingFormats[line.level - 1];
+			break;
+		case RenderedLine::Type::ListItem:
+			blockFormat.setIndent(line.level + 1);
+			break;
+		case RenderedLine::Type::Quote:
+			blockFormat.setIndent(1);
+			format = m_quoteFormat;
+			break;
+		case RenderedLine::Type::Rule:
+			blockFormat.setProperty(QTextFormat::BlockTrailingHorizontalRulerWidth,
+				QTextLength(QTextLength::PercentageLength, 100));
+			break;
+		case RenderedLine::Type::Fence:
+		case RenderedLine::Type::Code:
+			blockFormat.setBackground(m_codeBackground);
+			blockFormat.setNonBreakableLines(true);
+			format = m_codeFormat;
+			break;
+	}
+
+	cursor.setBlockFormat(blockFormat);
+	cursor.setBlockCharFormat(format);
+
+	int position = 0;
+	for (const RenderedLine::Span& span : line.spans)
+	{
+		if (span.start > position)
+			cursor.insertText(line.text.mid(position, span.start - position), format);
+
+		QTextCharFormat spanFormat = format;
+		if (span.style & RenderedLine::cBold)
+			spanFormat.setFontWeight(QFont::Bold);
+		if (span.style & RenderedLine::cItalic)
+			spanFormat.setFontItalic(true);
+		if (span.style & RenderedLine::cCode)
+			spanFormat.merge(m_codeFormat);
+		if (span.style & RenderedLine::cLink)
+		{
+			spanFormat.merge(m_linkFormat);
+			spanFormat.setAnchorHref(line.links[span.link]);
+		}
+		cursor.insertText(line.text.mid(span.start, span.length), spanFormat);
+		position = span.start + span.length;
+	}
+
+	if (position < line.text.size())
+		cursor.insertText(line.text.mid(position), format);
+}
+
+void MarkdownPreview::replaceLine(const QTextBlock& block, const RenderedLine& line) const
+{
+	QTextCursor cursor(block);
+	cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+	cursor.removeSelectedText();
+	writeLine(cursor, line);
+}
+
+} // namespace NoteVault
@@ -0,0 +1,81 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtGui/QBrush>
+#include <QtGui/QTextCharFormat>
+#include <QtGui/QTextDocument>
+
+class QTextBlock;
+class QTextCursor;
+
+namespace NoteVault
+{
+
+// Renders a subset of Markdown from the document being edited into a document to show next to
+// the editor. Each line of the source is rendered on its own, with only whether a code fence is
+// open carried over from the line before, so an edit only renders the lines it touched. Rendered
+// lines are cached in the user data of the source blocks, which keeps them for as long as the
+// note's document is kept.
+class MarkdownPreview : public QObject
+{
+	Q_OBJECT
+public:
+	explicit MarkdownPreview(QObject* parent = nullptr);
+	~MarkdownPreview();
+
+	// Document holding the rendered text, such as to show in a QTextBrowser.
+	QTextDocument* getDocument()	{return &m_document;}
+
+	QTextDocument* getSourceDocument() const	{return m_source;}
+	void setSourceDocument(QTextDocument* source);
+
+	// Nothing is rendered while disabled, such as when the preview is hidden.
+	bool isEnabled() const	{return m_enabled;}
+	void setEnabled(bool enabled);
+
+	// Font for normal text. Headings and code are sized relative to it.
+	void setFont(const QFont& font);
+
+private Q_SLOTS:
+	void onContentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+	class RenderedLine;
+
+	MarkdownPreview(const MarkdownPreview&) = delete;
+	MarkdownPreview& operator=(const MarkdownPreview&) = delete;
+
+	void rebuild();
+	void updateFormats();
+	const RenderedLine& renderLine(QTextBlock block, bool inFence, bool force);
+	void writeLine(QTextCursor& cursor, const RenderedLine& line) const;
+	void replaceLine(const QTextBlock& block, const RenderedLine& line) const;
+
+	QTextDocument m_document;
+	QPointer<QTextDocument> m_source;
+	QTextCharFormat m_textFormat;
+	QTextCharFormat m_headingFormats[6];
+	QTextCharFormat m_quoteFormat;
+	QTextCharFormat m_codeFormat;
+	QTextCharFormat m_linkFormat;
+	QBrush m_codeBackground;
+	bool m_enabled;
+};
+
+} // namespace NoteVault
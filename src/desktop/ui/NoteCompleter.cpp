@@ -0,0 +1,184 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NoteCompleter.h"
+
+#include "notes/Vocabulary.h"
+#include <QtCore/QCoreApplication>
+#include <QtGui/QKeyEvent>
+#include <QtGui/QTextBlock>
+#include <QtGui/QTextCursor>
+#include <QtWidgets/QAbstractItemView>
+#include <QtWidgets/QPlainTextEdit>
+#include <QtWidgets/QScrollBar>
+#include <string>
+#include <vector>
+
+#include "NoteCompleter.moc"
+
+namespace NoteVault
+{
+
+static const int cMaxCompletions = 8;
+static const int cMinPrefixLength = 2;
+
+static bool isWordChar(QChar c)
+{
+	return c.unicode() >= 0x80 || Vocabulary::isWordChar(static_cast<char>(c.unicode()));
+}
+
+NoteCompleter::NoteCompleter(QPlainTextEdit* editor, const Vocabulary& vocabulary,
+	QObject* parent)
+	: QObject(parent), m_editor(editor), m_vocabulary(&vocabulary)
+{
+	m_completer.setModel(&m_model);
+	m_completer.setWidget(editor);
+	m_completer.setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+	m_completer.setMaxVisibleItems(cMaxCompletions);
+	QObject::connect(&m_completer, SIGNAL(activated(const QString&)),
+		this, SLOT(onActivated(const QString&)));
+
+	// The popup takes the keys while it's shown. Filtering them here runs before the completer's
+	// own filter, which would otherwise take Enter even when nothing is selected.
+	editor->installEventFilter(this);
+	m_completer.popup()->installEventFilter(this);
+}
+
+NoteCompleter::~NoteCompleter()
+{
+}
+
+void NoteCompleter::clear()
+{
+	m_completer.popup()->hide();
+	m_model.setStringList(QStringList());
+}
+
+bool NoteCompleter::eventFilter(QObject* watched, QEvent* event)
+{
+	if (event->type() != QEvent::KeyPress)
+		return false;
+
+	QKeyEvent* keyEvent = static_cast<QKeyEvent*>(event);
+	QAbstractItemView* popup = m_completer.popup();
+	if (watched == popup)
+	{
+		switch (keyEvent->key())
+		{
+			case Qt::Key_Tab:
+			case Qt::Key_Return:
+			case Qt::Key_Enter:
+			{
+				QModelIndex index = popup->currentIndex();
+				if (!index.isValid() && keyEvent->key() == Qt::Key_Tab)
+					index = m_model.index(0, 0);
+
+				popup->hide();
+				if (index.isValid())
+					insertCompletion(index.data().toString());
+				else
+					QCoreApplication::sendEvent(m_editor, event);
+				return true;
+			}
+			case Qt::Key_Escape:
+				popup->hide();
+				return true;
+			default:
+				break;
+		}
+	}
+	else if (watched != m_editor)
+		return false;
+
+	// Keys given to the popup are passed on to the editor without going through its event filters,
+	// so both are checked for changes to the text. The completions are updated once the editor
+	// has handled the key.
+	QString text = keyEvent->text();
+	if ((!text.isEmpty() && text[0].isPrint()) || keyEvent->key() == Qt::Key_Backspace)
+		QMetaObject::invokeMethod(this, "updateCompletions", Qt::QueuedConnection);
+	return false;
+}
+
+void NoteCompleter::updateCompletions()
+{
+	QStringList completions;
+	QString prefix = getPrefix();
+	if (!m_editor->isReadOnly() && prefix.size() >= cMinPrefixLength)
+	{
+		// The prefix itself isn't worth offering when it's already a word.
+		QByteArray prefixUtf8 = prefix.toUtf8();
+		std::vector<std::string> words;
+		m_vocabulary->complete(words, prefixUtf8.constData(),
+			static_cast<size_t>(prefixUtf8.size()), cMaxCompletions + 1);
+		for (const std::string& word : words)
+		{
+			if (word.size() > static_cast<size_t>(prefixUtf8.size()) &&
+				completions.size() < cMaxCompletions)
+			{
+				completions.append(QString::fromStdString(word));
+			}
+		}
+	}
+
+	if (completions.isEmpty())
+	{
+		clear();
+		return;
+	}
+
+	m_model.setStringList(completions);
+	QAbstractItemView* popup = m_completer.popup();
+	QRect rect = m_editor->cursorRect();
+	rect.setWidth(popup->sizeHintForColumn(0) + popup->verticalScrollBar()->sizeHint().width());
+	m_completer.complete(rect);
+	popup->setCurrentIndex(QModelIndex());
+}
+
+void NoteCompleter::onActivated(const QString& completion)
+{
+	insertCompletion(completion);
+}
+
+QString NoteCompleter::getPrefix() const
+{
+	// Only complete at the end of a word, not when typing in the middle of one.
+	QTextCursor cursor = m_editor->textCursor();
+	if (cursor.hasSelection())
+		return QString();
+
+	QString text = cursor.block().text();
+	int end = cursor.positionInBlock();
+	if (end < static_cast<int>(text.size()) && isWordChar(text[end]))
+		return QString();
+
+	int start = end;
+	while (start > 0 && isWordChar(text[start - 1]))
+		--start;
+	return text.mid(start, end - start);
+}
+
+void NoteCompleter::insertCompletion(const QString& completion)
+{
+	QString prefix = getPrefix();
+	if (!completion.startsWith(prefix))
+		return;
+
+	QTextCursor cursor = m_editor->textCursor();
+	cursor.insertText(completion.mid(prefix.size()));
+	m_editor->setTextCursor(cursor);
+}
+
+} // namespace NoteVault
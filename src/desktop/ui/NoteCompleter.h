@@ -0,0 +1,62 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <QtCore/QObject>
+#include <QtCore/QStringListModel>
+#include <QtWidgets/QCompleter>
+
+class QPlainTextEdit;
+
+namespace NoteVault
+{
+
+class Vocabulary;
+
+// Offers to complete the word being typed in the note editor with the most used words from the
+// vocabulary. Completions are looked up after each key that changes the text, and are shown in a
+// popup at the cursor. Tab takes the selected or first completion, Enter only takes a completion
+// once one is selected so it still starts a new line otherwise, and Escape closes the popup.
+class NoteCompleter : public QObject
+{
+	Q_OBJECT
+public:
+	NoteCompleter(QPlainTextEdit* editor, const Vocabulary& vocabulary, QObject* parent = nullptr);
+	~NoteCompleter();
+
+	// Hides the popup and releases the completions it was showing.
+	void clear();
+
+	bool eventFilter(QObject* watched, QEvent* event) override;
+
+private Q_SLOTS:
+	void updateCompletions();
+	void onActivated(const QString& completion);
+
+private:
+	NoteCompleter(const NoteCompleter&) = delete;
+	NoteCompleter& operator=(const NoteCompleter&) = delete;
+
+	QString getPrefix() const;
+	void insertCompletion(const QString& completion);
+
+	QPlainTextEdit* m_editor;
+	const Vocabulary* m_vocabulary;
+	QStringListModel m_model;
+	QCompleter m_completer;
+};
+
+} // namespace NoteVault
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NoteDocumentCache.h"
+#include <QtGui/QTextDocument>
+#include <QtWidgets/QPlainTextDocumentLayout>
+
+namespace NoteVault
+{
+
+const size_t NoteDocumentCache::cDefaultMemoryBudget;
+
+static size_t getDocumentSize(const QTextDocument& document)
+{
+	// Text is stored as UTF-16, with roughly as much again for the layout and undo history.
+	return static_cast<size_t>(document.characterCount())*sizeof(QChar)*2;
+}
+
+NoteDocumentCache::NoteDocumentCache(size_t memoryBudget)
+	: m_memoryBudget(memoryBudget)
+{
+}
+
+NoteDocumentCache::~NoteDocumentCache()
+{
+}
+
+void NoteDocumentCache::setMemoryBudget(size_t bytes)
+{
+	m_memoryBudget = bytes;
+	trim();
+}
+
+QTextDocument* NoteDocumentCache::acquire(uint64_t id, bool& created)
+{
+	std::unordered_map<uint64_t, EntryList::iterator>::iterator foundIter = m_entryMap.find(id);
+	if (foundIter != m_entryMap.end())
+	{
+		m_entries.splice(m_entries.begin(), m_entries, foundIter->second);
+		created = false;
+		return m_entries.front().document.get();
+	}
+
+	QTextDocument* document = new QTextDocument;
+	document->setDocumentLayout(new QPlainTextDocumentLayout(document));
+
+	Entry entry = {id, std::unique_ptr<QTextDocument>(document)};
+	m_entries.push_front(std::move(entry));
+	m_entryMap[id] = m_entries.begin();
+	created = true;
+	return document;
+}
+
+QTextDocument* NoteDocumentCache::find(uint64_t id) const
+{
+	std::unordered_map<uint64_t, EntryList::iterator>::const_iterator foundIter =
+		m_entryMap.find(id);
+	if (foundIter == m_entryMap.end())
+		return nullptr;
+	return foundIter->second->document.get();
+}
+
+void NoteDocumentCache::remove(uint64_t id)
+{
+	std::unordered_map<uint64_t, EntryList::iterator>::iterator foundIter = m_entryMap.find(id);
+	if (foundIter == m_entryMap.end())
+		return;
+
+	m_entries.erase(foundIter->second);
+	m_entryMap.erase(foundIter);
+}
+
+void NoteDocumentCache::clear()
+{
+	m_entryMap.clear();
+	m_entries.clear();
+}
+
+void NoteDocumentCache::trim()
+{
+	size_t totalSize = 0;
+	for (const Entry& entry : m_entries)
+		totalSize += getDocumentSize(*entry.document);
+
+	while (totalSize > m_memoryBudget && m_entries.size() > 1)
+	{
+		const Entry& entry = m_entries.back();
+		totalSize -= getDocumentSize(*entry.document);
+		m_entryMap.erase(entry.id);
+		m_entries.pop_back();
+	}
+}
+
+} // namespace NoteVault
@@ -0,0 +1,76 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+class QTextDocument;
+
+namespace NoteVault
+{
+
+// Least recently used cache of documents for editing notes. Keeping the documents around avoids
+// laying out the text again when switching between notes and preserves their undo history.
+// Documents are only evicted by trim(), which never evicts the most recently used document. When
+// a document is acquired the editor still shows the previous one, so trim() is called once the
+// editor has switched to the new document.
+class NoteDocumentCache
+{
+public:
+	static const size_t cDefaultMemoryBudget = 64*1024*1024;
+
+	explicit NoteDocumentCache(size_t memoryBudget = cDefaultMemoryBudget);
+	~NoteDocumentCache();
+
+	size_t getMemoryBudget() const	{return m_memoryBudget;}
+	void setMemoryBudget(size_t bytes);
+
+	// Returns the document for a note, marking it as the most recently used. If it isn't cached,
+	// a new empty document is created for use with QPlainTextEdit and created is set to true.
+	QTextDocument* acquire(uint64_t id, bool& created);
+
+	// Evicts the least recently used documents until the cache is within its budget, keeping the
+	// most recently used document.
+	void trim();
+
+	QTextDocument* find(uint64_t id) const;
+	void remove(uint64_t id);
+	void clear();
+
+	size_t size() const	{return m_entries.size();}
+
+private:
+	NoteDocumentCache(const NoteDocumentCache&) = delete;
+	NoteDocumentCache& operator=(const NoteDocumentCache&) = delete;
+
+	struct Entry
+	{
+		uint64_t id;
+		std::unique_ptr<QTextDocument> document;
+	};
+
+	using EntryList = std::list<Entry>;
+
+	EntryList m_entries;
+	std::unordered_map<uint64_t, EntryList::iterator> m_entryMap;
+	size_t m_memoryBudget;
+};
+
+} // namespace NoteVault
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NoteHighlighter.h"
+
+#include <QtCore/QStringList>
+#include <QtCore/QStringView>
+#include <QtGui/QColor>
+#include <QtGui/QFontDatabase>
+#include <QtGui/QGuiApplication>
+#include <QtGui/QPalette>
+
+#include "NoteHighlighter.moc"
+
+namespace NoteVault
+{
+
+// State carried over to the next block. Blocks that haven't been highlighted yet have a state of
+// -1, which is treated as normal text.
+static const int cTextState = 0;
+static const int cCodeState = 1;
+static const int cPemState = 2;
+
+// Shortest run of hex digits that's taken as a key, which is 128 bits.
+static const int cMinHexKeyLength = 32;
+
+static bool isFence(QStringView line)
+{
+	return line.startsWith(u"```") || line.startsWith(u"~~~");
+}
+
+static bool isTokenSeparator(QChar c)
+{
+	switch (c.unicode())
+	{
+		case u'"':
+		case u'\'':
+		case u'`':
+		case u'=':
+		case u':':
+		case u',':
+		case u';':
+		case u'(':
+		case u')':
+		case u'[':
+		case u']':
+		case u'{':
+		case u'}':
+		case u'<':
+		case u'>':
+			return true;
+		default:
+			return c.isSpace();
+	}
+}
+
+static bool isBase64UrlChar(QChar c)
+{
+	char16_t code = c.unicode();
+	return (code >= u'A' && code <= u'Z') || (code >= u'a' && code <= u'z') ||
+		(code >= u'0' && code <= u'9') || code == u'-' || code == u'_';
+}
+
+static bool isHexDigit(QChar c)
+{
+	char16_t code = c.unicode();
+	return (code >= u'0' && code <= u'9') || (code >= u'a' && code <= u'f') ||
+		(code >= u'A' && code <= u'F');
+}
+
+// The header always starts with the encoded '{"'. The signature is empty for unsigned tokens.
+static bool isJsonWebToken(QStringView token)
+{
+	if (!token.startsWith(u"eyJ"))
+		return false;
+
+	int dots = 0;
+	int segmentLength = 0;
+	for (QChar c : token)
+	{
+		if (c == u'.')
+		{
+			if (segmentLength == 0 || ++dots > 2)
+				return false;
+			segmentLength = 0;
+		}
+		else if (isBase64UrlChar(c))
+			++segmentLength;
+		else
+			return false;
+	}
+	return dots == 2;
+}
+
+static bool isHexKey(QStringView token)
+{
+	if (token.startsWith(u"0x") || token.startsWith(u"0X"))
+		token = token.mid(2);
+	if (token.size() < cMinHexKeyLength)
+		return false;
+
+	for (QChar c : token)
+	{
+		if (!isHexDigit(c))
+			return false;
+	}
+	return true;
+}
+
+NoteHighlighter::NoteHighlighter(QTextDocument* parent)
+	: QSyntaxHighlighter(parent)
+{
+	QPalette palette = QGuiApplication::palette();
+	QStringList codeFamilies(QFontDatabase::systemFont(QFontDatabase::FixedFont).family());
+
+	m_codeFormat.setFontFamilies(codeFamilies);
+	m_codeFormat.setFontFixedPitch(true);
+	m_codeFormat.setBackground(palette.alternateBase());
+
+	m_fenceFormat = m_codeFormat;
+	m_fenceFormat.setForeground(palette.placeholderText());
+
+	m_secretFormat.setFontFamilies(codeFamilies);
+	m_secretFormat.setFontFixedPitch(true);
+	m_secretFormat.setForeground(QColor(Qt::darkMagenta));
+
+	m_codeSecretFormat = m_codeFormat;
+	m_codeSecretFormat.merge(m_secretFormat);
+}
+
+NoteHighlighter::~NoteHighlighter()
+{
+}
+
+void NoteHighlighter::highlightBlock(const QString& text)
+{
+	int state = previousBlockState();
+	int length = static_cast<int>(text.size());
+	QStringView line = QStringView(text).trimmed();
+	if (state == cCodeState)
+	{
+		if (isFence(line))
+		{
+			setFormat(0, length, m_fenceFormat);
+			setCurrentBlockState(cTextState);
+		}
+		else
+		{
+			// Config snippets in code often hold keys as well.
+			setFormat(0, length, m_codeFormat);
+			highlightSecrets(text, m_codeSecretFormat);
+			setCurrentBlockState(cCodeState);
+		}
+		return;
+	}
+	else if (state == cPemState)
+	{
+		setFormat(0, length, m_secretFormat);
+		setCurrentBlockState(line.startsWith(u"-----END ") ? cTextState : cPemState);
+		return;
+	}
+
+	if (isFence(line))
+	{
+		setFormat(0, length, m_fenceFormat);
+		setCurrentBlockState(cCodeState);
+	}
+	else if (line.startsWith(u"-----BEGIN ") && line.endsWith(u"-----"))
+	{
+		setFormat(0, length, m_secretFormat);
+		setCurrentBlockState(cPemState);
+	}
+	else
+	{
+		highlightSecrets(text, m_secretFormat);
+		setCurrentBlockState(cTextState);
+	}
+}
+
+void NoteHighlighter::highlightSecrets(const QString& text, const QTextCharFormat& format)
+{
+	int size = static_cast<int>(text.size());
+	int start = 0;
+	while (start < size)
+	{
+		if (isTokenSeparator(text[start]))
+		{
+			++start;
+			continue;
+		}
+
+		int end = start + 1;
+		while (end < size && !isTokenSeparator(text[end]))
+			++end;
+
+		QStringView token = QStringView(text).mid(start, end - start);
+		if (isJsonWebToken(token))
+			setFormat(start, end - start, format);
+		else
+		{
+			// Keys may be at the end of a sentence.
+			while (token.endsWith(u'.'))
+				token.chop(1);
+			if (isHexKey(token))
+				setFormat(start, static_cast<int>(token.size()), format);
+		}
+
+		start = end;
+	}
+}
+
+} // namespace NoteVault
@@ -0,0 +1,51 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <QtGui/QSyntaxHighlighter>
+#include <QtGui/QTextCharFormat>
+
+namespace NoteVault
+{
+
+// Highlights fenced code blocks and text that looks like a secret: PEM blocks, JSON web tokens,
+// and long hex keys. Whether a block is inside of a code fence or PEM block is kept as the block
+// state, so only the blocks that change are highlighted again, along with any after them whose
+// state changes as a result. Highlighting starts as text is added to the document, so attaching
+// the highlighter before loading a large note highlights the start of it first.
+class NoteHighlighter : public QSyntaxHighlighter
+{
+	Q_OBJECT
+public:
+	explicit NoteHighlighter(QTextDocument* parent);
+	~NoteHighlighter();
+
+protected:
+	void highlightBlock(const QString& text) override;
+
+private:
+	NoteHighlighter(const NoteHighlighter&) = delete;
+	NoteHighlighter& operator=(const NoteHighlighter&) = delete;
+
+	void highlightSecrets(const QString& text, const QTextCharFormat& format);
+
+	QTextCharFormat m_fenceFormat;
+	QTextCharFormat m_codeFormat;
+	QTextCharFormat m_secretFormat;
+	QTextCharFormat m_codeSecretFormat;
+};
+
+} // namespace NoteVault
@@ -0,0 +1,43 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "notes/NoteBody.h"
+#include "notes/NoteString.h"
+#include <QtCore/QString>
+
+namespace NoteVault
+{
+
+inline QString toQString(const NoteString& string)
+{
+	return QString::fromUtf8(string.data(), static_cast<qsizetype>(string.size()));
+}
+
+inline QString toQString(const NoteBody& body)
+{
+	// Pieces are split on character boundaries, so they can be decoded separately.
+	QString string;
+	string.reserve(static_cast<qsizetype>(body.size()));
+	for (size_t i = 0; i < body.getPieceCount(); ++i)
+	{
+		const NoteBody::Piece& piece = body.getPiece(i);
+		string.append(QString::fromUtf8(piece.data, static_cast<qsizetype>(piece.size)));
+	}
+	return string;
+}
+
+} // namespace NoteVault
@@ -0,0 +1,454 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NoteTreeModel.h"
+
+#include "NoteStrings.h"
+#include "notes/NoteSet.h"
+#include <QtCore/QDataStream>
+#include <QtCore/QMimeData>
+#include <QtWidgets/QApplication>
+#include <QtWidgets/QStyle>
+
+#include "NoteTreeModel.moc"
+
+namespace NoteVault
+{
+
+// Above this many notes inserted, removed, or moved in one batch, the tree is rebuilt and the model
+// is reset instead.
+static const size_t cMaxRowChanges = 256;
+
+// Notes dragged within the view. Ids only have meaning within a set, so the data starts with the
+// model it came from to keep it from being dropped in another window.
+static const char* const cNoteMimeType = "application/x-notevault-notes";
+
+static quint64 getModelKey(const NoteTreeModel* model)
+{
+	return static_cast<quint64>(reinterpret_cast<quintptr>(model));
+}
+
+NoteTreeModel::NoteTreeModel(QObject* parent)
+	: QAbstractItemModel(parent), m_notes(nullptr),
+	m_folderIcon(QApplication::style()->standardIcon(QStyle::SP_DirIcon)), m_editable(true)
+{
+}
+
+NoteTreeModel::~NoteTreeModel()
+{
+}
+
+void NoteTreeModel::setNoteSet(const NoteSet* notes)
+{
+	beginResetModel();
+	m_notes = notes;
+	m_fetchedFolders.clear();
+	if (notes)
+		m_tree.build(*notes);
+	else
+		m_tree.clear();
+	endResetModel();
+}
+
+uint64_t NoteTreeModel::getNoteId(const QModelIndex& index) const
+{
+	if (!index.isValid())
+		return Note::cNoParent;
+	return *static_cast<const uint64_t*>(index.internalPointer());
+}
+
+QModelIndex NoteTreeModel::indexOf(uint64_t id)
+{
+	if (!m_notes || !m_tree.isReachable(id))
+		return QModelIndex();
+
+	std::vector<uint64_t> folders;
+	for (uint64_t parentId = m_tree.getParent(id); parentId != Note::cNoParent;
+		parentId = m_tree.getParent(parentId))
+	{
+		folders.push_back(parentId);
+	}
+
+	for (std::vector<uint64_t>::const_reverse_iterator iter = folders.rbegin();
+		iter != folders.rend(); ++iter)
+	{
+		if (m_fetchedFolders.count(*iter) == 0)
+			fetchMore(indexForId(*iter));
+	}
+
+	return indexForId(id);
+}
+
+void NoteTreeModel::notesChanged(NoteSet& notes, const std::vector<NoteChange>& changes)
+{
+	if (&notes != m_notes)
+		return;
+
+	// Only where the notes are in the tree matters, not their order in the set.
+	std::vector<uint64_t> changedIds;
+	std::unordered_set<uint64_t> seenIds;
+	for (const NoteChange& change : changes)
+	{
+		switch (change.type)
+		{
+			case NoteChange::Type::Inserted:
+			case NoteChange::Type::Removed:
+			case NoteChange::Type::TitleChanged:
+			case NoteChange::Type::ParentChanged:
+				if (seenIds.insert(change.id).second)
+					changedIds.push_back(change.id);
+				break;
+			case NoteChange::Type::MessageChanged:
+			case NoteChange::Type::Moved:
+			case NoteChange::Type::Reordered:
+				break;
+			case NoteChange::Type::Reset:
+				setNoteSet(&notes);
+				return;
+		}
+	}
+
+	if (changedIds.empty())
+		return;
+
+	// Renaming or moving a single note keeps its row, along with the selection and whether it's
+	// expanded.
+	if (changedIds.size() == 1 && moveNote(notes, changedIds[0]))
+		return;
+
+	// Rebuilding the tree is cheaper than moving many notes one at a time, since each one is
+	// inserted into or searched for in the list for its folder. This applies to folders that
+	// haven't been expanded as well, though the view collapses every folder when reset.
+	if (changedIds.size() > cMaxRowChanges)
+	{
+		setNoteSet(&notes);
+		return;
+	}
+
+	// Take every changed note out before adding them back so the lists they're added to are
+	// sorted.
+	for (uint64_t id : changedIds)
+		detachNote(notes, id);
+	for (uint64_t id : changedIds)
+		attachNote(notes, id);
+}
+
+QModelIndex NoteTreeModel::index(int row, int column, const QModelIndex& parent) const
+{
+	if (!m_notes || row < 0 || column != 0)
+		return QModelIndex();
+
+	uint64_t parentId = getNoteId(parent);
+	if (parent.isValid() && m_fetchedFolders.count(parentId) == 0)
+		return QModelIndex();
+
+	const NoteTree::ChildList& children = m_tree.getChildren(parentId);
+	if (static_cast<size_t>(row) >= children.size())
+		return QModelIndex();
+	return createIndex(row, 0, m_tree.findId(children[row]));
+}
+
+QModelIndex NoteTreeModel::parent(const QModelIndex& index) const
+{
+	if (!index.isValid())
+		return QModelIndex();
+	return indexForId(m_tree.getParent(getNoteId(index)));
+}
+
+int NoteTreeModel::rowCount(const QModelIndex& parent) const
+{
+	if (!m_notes || parent.column() > 0)
+		return 0;
+
+	uint64_t parentId = getNoteId(parent);
+	if (parent.isValid() && m_fetchedFolders.count(parentId) == 0)
+		return 0;
+	return static_cast<int>(m_tree.getChildren(parentId).size());
+}
+
+int NoteTreeModel::columnCount(const QModelIndex&) const
+{
+	return 1;
+}
+
+bool NoteTreeModel::hasChildren(const QModelIndex& parent) const
+{
+	if (!parent.isValid())
+		return rowCount(parent) > 0;
+
+	// Folders can be expanded until their rows are added, even if they turn out to be empty.
+	const Note* note = getNote(parent);
+	if (!note || !note->isFolder())
+		return false;
+	return m_fetchedFolders.count(note->getId()) == 0 ||
+		!m_tree.getChildren(note->getId()).empty();
+}
+
+bool NoteTreeModel::canFetchMore(const QModelIndex& parent) const
+{
+	const Note* note = getNote(parent);
+	return note && note->isFolder() && m_fetchedFolders.count(note->getId()) == 0;
+}
+
+void NoteTreeModel::fetchMore(const QModelIndex& parent)
+{
+	if (!canFetchMore(parent))
+		return;
+
+	uint64_t id = getNoteId(parent);
+	size_t childCount = m_tree.getChildren(id).size();
+	if (childCount == 0)
+	{
+		m_fetchedFolders.insert(id);
+		return;
+	}
+
+	beginInsertRows(parent, 0, static_cast<int>(childCount) - 1);
+	m_fetchedFolders.insert(id);
+	endInsertRows();
+}
+
+QVariant NoteTreeModel::data(const QModelIndex& index, int role) const
+{
+	const Note* note = getNote(index);
+	if (!note)
+		return QVariant();
+
+	switch (role)
+	{
+		case Qt::DisplayRole:
+		case Qt::EditRole:
+			return toQString(note->getTitle());
+		case Qt::DecorationRole:
+			if (note->isFolder())
+				return m_folderIcon;
+			break;
+		default:
+			break;
+	}
+	return QVariant();
+}
+
+bool NoteTreeModel::setData(const QModelIndex& index, const QVariant& value, int role)
+{
+	if (!getNote(index) || role != Qt::EditRole)
+		return false;
+
+	Q_EMIT titleEdited(getNoteId(index), value.toString());
+	return true;
+}
+
+Qt::ItemFlags NoteTreeModel::flags(const QModelIndex& index) const
+{
+	// Notes can be dropped into folders or the root.
+	if (!index.isValid())
+		return m_editable ? Qt::ItemIsDropEnabled : Qt::NoItemFlags;
+
+	const Note* note = getNote(index);
+	if (!note)
+		return Qt::NoItemFlags;
+
+	Qt::ItemFlags flags = QAbstractItemModel::flags(index);
+	if (m_editable)
+	{
+		flags |= Qt::ItemIsEditable | Qt::ItemIsDragEnabled;
+		if (note->isFolder())
+			flags |= Qt::ItemIsDropEnabled;
+	}
+	if (!note->isFolder())
+		flags |= Qt::ItemNeverHasChildren;
+	return flags;
+}
+
+Qt::DropActions NoteTreeModel::supportedDropActions() const
+{
+	return Qt::MoveAction;
+}
+
+QStringList NoteTreeModel::mimeTypes() const
+{
+	return QStringList(cNoteMimeType);
+}
+
+QMimeData* NoteTreeModel::mimeData(const QModelIndexList& indexes) const
+{
+	QByteArray encoded;
+	QDataStream stream(&encoded, QIODevice::WriteOnly);
+	stream << getModelKey(this);
+	for (const QModelIndex& index : indexes)
+	{
+		if (index.isValid())
+			stream << static_cast<quint64>(getNoteId(index));
+	}
+
+	QMimeData* data = new QMimeData;
+	data->setData(cNoteMimeType, encoded);
+	return data;
+}
+
+bool NoteTreeModel::dropMimeData(const QMimeData* data, Qt::DropAction action, int, int,
+	const QModelIndex& parent)
+{
+	if (action == Qt::IgnoreAction)
+		return true;
+	if (!m_editable || action != Qt::MoveAction || !data->hasFormat(cNoteMimeType))
+		return false;
+
+	const Note* folder = getNote(parent);
+	if (parent.isValid() && (!folder || !folder->isFolder()))
+		return false;
+
+	QByteArray encoded = data->data(cNoteMimeType);
+	QDataStream stream(&encoded, QIODevice::ReadOnly);
+	quint64 modelKey = 0;
+	stream >> modelKey;
+	if (modelKey != getModelKey(this))
+		return false;
+
+	QList<quint64> ids;
+	while (!stream.atEnd())
+	{
+		quint64 id;
+		stream >> id;
+		ids.append(id);
+	}
+
+	// The row dropped at doesn't matter since folders are sorted.
+	Q_EMIT notesDropped(ids, getNoteId(parent));
+	return true;
+}
+
+const Note* NoteTreeModel::getNote(const QModelIndex& index) const
+{
+	if (!m_notes || !index.isValid())
+		return nullptr;
+	return m_notes->find_note(getNoteId(index));
+}
+
+QModelIndex NoteTreeModel::indexForId(uint64_t id) const
+{
+	if (id == Note::cNoParent)
+		return QModelIndex();
+
+	size_t row = m_tree.indexOf(*m_notes, id);
+	if (row == NoteTree::cNotFound)
+		return QModelIndex();
+	return createIndex(static_cast<int>(row), 0, m_tree.findId(id));
+}
+
+bool NoteTreeModel::isFolderShown(uint64_t folderId) const
+{
+	if (!m_tree.isReachable(folderId))
+		return false;
+
+	for (; folderId != Note::cNoParent; folderId = m_tree.getParent(folderId))
+	{
+		if (m_fetchedFolders.count(folderId) == 0)
+			return false;
+	}
+	return true;
+}
+
+bool NoteTreeModel::moveNote(const NoteSet& notes, uint64_t id)
+{
+	const Note* note = notes.find_note(id);
+	if (!note || !m_tree.contains(id))
+		return false;
+
+	uint64_t oldParentId = m_tree.getParent(id);
+	uint64_t newParentId = note->getParentId();
+	if (!isFolderShown(oldParentId) || !isFolderShown(newParentId))
+		return false;
+
+	// The indices are taken before the move, as the view expects. Where the note belongs is found
+	// without it in the list, then it's put back until the move is reported.
+	QModelIndex oldParent = indexForId(oldParentId);
+	QModelIndex newParent = indexForId(newParentId);
+	size_t oldRow = m_tree.remove(id);
+	size_t newRow = m_tree.findInsertIndex(notes, *note);
+	m_tree.insert(id, oldParentId, oldRow);
+
+	if (oldParentId == newParentId && newRow == oldRow)
+	{
+		QModelIndex changedIndex = createIndex(static_cast<int>(oldRow), 0, m_tree.findId(id));
+		Q_EMIT dataChanged(changedIndex, changedIndex);
+		return true;
+	}
+
+	// The destination is the row to insert before, prior to removing the moved row. Moving a
+	// folder into itself is refused, in which case the general path drops it from the view.
+	int destRow = static_cast<int>(newRow);
+	if (oldParentId == newParentId && newRow > oldRow)
+		++destRow;
+	if (!beginMoveRows(oldParent, static_cast<int>(oldRow), static_cast<int>(oldRow), newParent,
+			destRow))
+	{
+		return false;
+	}
+
+	m_tree.remove(id);
+	m_tree.insert(id, newParentId, newRow);
+	endMoveRows();
+
+	QModelIndex changedIndex = createIndex(static_cast<int>(newRow), 0, m_tree.findId(id));
+	Q_EMIT dataChanged(changedIndex, changedIndex);
+	return true;
+}
+
+void NoteTreeModel::detachNote(const NoteSet& notes, uint64_t id)
+{
+	if (m_tree.contains(id))
+	{
+		uint64_t parentId = m_tree.getParent(id);
+		if (isFolderShown(parentId))
+		{
+			int row = static_cast<int>(m_tree.indexOf(notes, id));
+			beginRemoveRows(indexForId(parentId), row, row);
+			m_tree.remove(id);
+			endRemoveRows();
+		}
+		else
+			m_tree.remove(id);
+	}
+
+	// Folders that are only renamed or moved keep the rows for their contents.
+	if (!notes.find_note(id))
+	{
+		m_tree.erase(id);
+		m_fetchedFolders.erase(id);
+	}
+}
+
+void NoteTreeModel::attachNote(const NoteSet& notes, uint64_t id)
+{
+	const Note* note = notes.find_note(id);
+	if (!note)
+		return;
+
+	uint64_t parentId = note->getParentId();
+	size_t index = m_tree.findInsertIndex(notes, *note);
+	if (isFolderShown(parentId))
+	{
+		int row = static_cast<int>(index);
+		beginInsertRows(indexForId(parentId), row, row);
+		m_tree.insert(id, parentId, index);
+		endInsertRows();
+	}
+	else
+		m_tree.insert(id, parentId, index);
+}
+
+} // namespace NoteVault
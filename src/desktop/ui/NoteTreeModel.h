@@ -0,0 +1,99 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "notes/NoteSetListener.h"
+#include "notes/NoteTree.h"
+#include <QtCore/QAbstractItemModel>
+#include <QtCore/QList>
+#include <QtGui/QIcon>
+#include <unordered_set>
+
+namespace NoteVault
+{
+
+// Tree model of the notes and folders, sorted within each folder. The rows for the notes in a
+// folder are only added once the view expands it, so only the folders that have been opened are
+// reported to the view. Changes to the notes must be forwarded with notesChanged().
+class NoteTreeModel : public QAbstractItemModel, public NoteSetListener
+{
+	Q_OBJECT
+public:
+	explicit NoteTreeModel(QObject* parent = nullptr);
+	~NoteTreeModel();
+
+	const NoteSet* getNoteSet() const	{return m_notes;}
+	void setNoteSet(const NoteSet* notes);
+
+	const NoteTree& getTree() const	{return m_tree;}
+
+	// Titles can't be edited and notes can't be moved from the view while the notes are read-only.
+	bool isEditable() const	{return m_editable;}
+	void setEditable(bool editable)	{m_editable = editable;}
+
+	// Returns Note::cNoParent for the root.
+	uint64_t getNoteId(const QModelIndex& index) const;
+
+	// Returns the index of a note, adding the rows for the folders it's in as needed. The index is
+	// invalid if the note can't be reached from the root.
+	QModelIndex indexOf(uint64_t id);
+
+	void notesChanged(NoteSet& notes, const std::vector<NoteChange>& changes) override;
+
+	QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+	QModelIndex parent(const QModelIndex& index) const override;
+	int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+	int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+	bool hasChildren(const QModelIndex& parent = QModelIndex()) const override;
+	bool canFetchMore(const QModelIndex& parent) const override;
+	void fetchMore(const QModelIndex& parent) override;
+
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+	bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
+	Qt::ItemFlags flags(const QModelIndex& index) const override;
+
+	Qt::DropActions supportedDropActions() const override;
+	QStringList mimeTypes() const override;
+	QMimeData* mimeData(const QModelIndexList& indexes) const override;
+	bool dropMimeData(const QMimeData* data, Qt::DropAction action, int row, int column,
+		const QModelIndex& parent) override;
+
+Q_SIGNALS:
+	// Titles aren't changed and notes aren't moved by the model so they can be handled as undoable
+	// commands.
+	void titleEdited(quint64 id, const QString& title);
+	void notesDropped(const QList<quint64>& ids, quint64 folderId);
+
+private:
+	NoteTreeModel(const NoteTreeModel&) = delete;
+	NoteTreeModel& operator=(const NoteTreeModel&) = delete;
+
+	const Note* getNote(const QModelIndex& index) const;
+	QModelIndex indexForId(uint64_t id) const;
+	bool isFolderShown(uint64_t folderId) const;
+
+	bool moveNote(const NoteSet& notes, uint64_t id);
+	void detachNote(const NoteSet& notes, uint64_t id);
+	void attachNote(const NoteSet& notes, uint64_t id);
+
+	const NoteSet* m_notes;
+	NoteTree m_tree;
+	std::unordered_set<uint64_t> m_fetchedFolders;
+	QIcon m_folderIcon;
+	bool m_editable;
+};
+
+} // namespace NoteVault
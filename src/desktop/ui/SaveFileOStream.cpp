@@ -0,0 +1,62 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SaveFileOStream.h"
+
+namespace NoteVault
+{
+
+SaveFileOStream::SaveFileOStream()
+{
+}
+
+SaveFileOStream::~SaveFileOStream()
+{
+	close();
+}
+
+bool SaveFileOStream::open(const std::string& fileName)
+{
+	close();
+	m_file.setFileName(QString::fromStdString(fileName));
+	return m_file.open(QIODevice::WriteOnly);
+}
+
+size_t SaveFileOStream::write(const void* data, size_t size)
+{
+	if (!m_file.isOpen())
+		return 0;
+
+	qint64 written = m_file.write(static_cast<const char*>(data), static_cast<qint64>(size));
+	return written < 0 ? 0 : static_cast<size_t>(written);
+}
+
+bool SaveFileOStream::commit()
+{
+	return m_file.isOpen() && m_file.commit();
+}
+
+void SaveFileOStream::close()
+{
+	// Committing after canceling removes the temporary file and closes it.
+	if (m_file.isOpen())
+	{
+		m_file.cancelWriting();
+		m_file.commit();
+	}
+}
+
+} // namespace NoteVault
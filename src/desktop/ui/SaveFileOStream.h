@@ -0,0 +1,43 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "io/OStream.h"
+#include <QtCore/QSaveFile>
+#include <string>
+
+namespace NoteVault
+{
+
+// Writes a file through a temporary file that only replaces the original once commit() is called,
+// so a crash or failed write in the middle of saving leaves the original file intact. Closing
+// without committing discards what was written.
+class SaveFileOStream : public OStream
+{
+public:
+	SaveFileOStream();
+	~SaveFileOStream();
+
+	bool open(const std::string& fileName);
+	size_t write(const void* data, size_t size) override;
+	bool commit();
+	void close() override;
+
+private:
+	QSaveFile m_file;
+};
+
+} // namespace NoteVault
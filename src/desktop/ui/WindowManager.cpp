@@ -0,0 +1,150 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WindowManager.h"
+#include "MainWindow.h"
+#include <QtCore/QFileInfo>
+#include <algorithm>
+
+#include "WindowManager.moc"
+
+namespace NoteVault
+{
+
+WindowManager::WindowManager(QObject* parent)
+	: QObject(parent), m_opening(false)
+{
+}
+
+WindowManager::~WindowManager()
+{
+	for (const QPointer<MainWindow>& window : m_windows)
+		delete window.data();
+}
+
+MainWindow* WindowManager::createWindow()
+{
+	m_windows.erase(std::remove_if(m_windows.begin(), m_windows.end(),
+		[](const QPointer<MainWindow>& window) {return window.isNull();}), m_windows.end());
+
+	MainWindow* window = new MainWindow;
+	window->setAttribute(Qt::WA_DeleteOnClose);
+	QObject::connect(window, SIGNAL(openFinished(bool)), this, SLOT(onOpenFinished(bool)));
+	m_windows.emplace_back(window);
+	return window;
+}
+
+void WindowManager::openFiles(const QStringList& filePaths)
+{
+	if (filePaths.isEmpty())
+	{
+		MainWindow* window = getLastWindow();
+		if (!window)
+		{
+			window = createWindow();
+			window->show();
+		}
+		activate(*window);
+		return;
+	}
+
+	// Opening prompts for the password in a nested event loop, where more files may be received.
+	// Queue them up so they're opened one at a time.
+	m_pendingFiles.append(filePaths);
+	if (m_opening)
+		return;
+
+	m_opening = true;
+	while (!m_pendingFiles.isEmpty())
+		openFile(m_pendingFiles.takeFirst());
+	m_opening = false;
+}
+
+void WindowManager::openFile(const QString& filePath)
+{
+	std::string absolutePath = QFileInfo(filePath).absoluteFilePath().toStdString();
+	if (MainWindow* window = findWindow(absolutePath))
+	{
+		activate(*window);
+		return;
+	}
+
+	MainWindow* window = findUnusedWindow();
+	if (!window)
+	{
+		window = createWindow();
+		m_newWindows.emplace_back(window);
+	}
+
+	window->show();
+	activate(*window);
+
+	// Only waits for the password; the file finishes loading in the background.
+	window->open(absolutePath);
+}
+
+void WindowManager::onOpenFinished(bool success)
+{
+	MainWindow* window = qobject_cast<MainWindow*>(sender());
+	std::vector<QPointer<MainWindow>>::iterator foundIter = std::find(m_newWindows.begin(),
+		m_newWindows.end(), window);
+	if (!window || foundIter == m_newWindows.end())
+		return;
+
+	m_newWindows.erase(foundIter);
+	if (!success && window->isUnused())
+		window->close();
+}
+
+MainWindow* WindowManager::findWindow(const std::string& filePath)
+{
+	for (const QPointer<MainWindow>& window : m_windows)
+	{
+		if (window && window->hasFile(filePath))
+			return window.data();
+	}
+	return nullptr;
+}
+
+MainWindow* WindowManager::findUnusedWindow()
+{
+	for (const QPointer<MainWindow>& window : m_windows)
+	{
+		if (window && window->isUnused())
+			return window.data();
+	}
+	return nullptr;
+}
+
+MainWindow* WindowManager::getLastWindow()
+{
+	for (auto it = m_windows.rbegin(); it != m_windows.rend(); ++it)
+	{
+		if (*it)
+			return it->data();
+	}
+	return nullptr;
+}
+
+void WindowManager::activate(MainWindow& window)
+{
+	if (window.isMinimized())
+		window.showNormal();
+	window.raise();
+	window.activateWindow();
+}
+
+} // namespace NoteVault
@@ -0,0 +1,65 @@
+#pragma once
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QStringList>
+#include <string>
+#include <vector>
+
+namespace NoteVault
+{
+
+class MainWindow;
+
+// Keeps track of the main windows, each with its own notes file.
+class WindowManager : public QObject
+{
+	Q_OBJECT
+public:
+	explicit WindowManager(QObject* parent = nullptr);
+	~WindowManager();
+
+	// The window is deleted once it's closed.
+	MainWindow* createWindow();
+
+public Q_SLOTS:
+	// Opens each file in its own window, reusing a window that already has the file open or hasn't
+	// been used yet. With no files, brings the most recent window to the front. Each file is
+	// loaded in the background once its password is entered, so multiple files are decrypted in
+	// parallel.
+	void openFiles(const QStringList& filePaths);
+
+private Q_SLOTS:
+	void onOpenFinished(bool success);
+
+private:
+	void openFile(const QString& filePath);
+	MainWindow* findWindow(const std::string& filePath);
+	MainWindow* findUnusedWindow();
+	MainWindow* getLastWindow();
+	static void activate(MainWindow& window);
+
+	std::vector<QPointer<MainWindow>> m_windows;
+
+	// Windows created to open a file, which are closed again if opening fails.
+	std::vector<QPointer<MainWindow>> m_newWindows;
+	QStringList m_pendingFiles;
+	bool m_opening;
+};
+
+} // namespace NoteVault